@@ -21,11 +21,14 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QGuiApplication>
+#include <QHash>
 #include <QImage>
+#include <QPointF>
 #include <QRectF>
 #include <QScopedPointer>
 #include <QScreen>
 #include <QString>
+#include <QStringList>
 #include <QTransform>
 
 #include <resvg.h>
@@ -81,13 +84,65 @@ static QString errorToString(const int err)
             return QLatin1String("SVG doesn't have a valid size.");
         case RESVG_ERROR_PARSING_FAILED :
             return QLatin1String("Failed to parse an SVG data.");
+        case RESVG_ERROR_NODES_LIMIT_REACHED :
+            return QLatin1String("Too many nodes.");
+        case RESVG_ERROR_DEPTH_LIMIT_REACHED :
+            return QLatin1String("Elements are nested too deep.");
+        case RESVG_ERROR_PATH_POINTS_LIMIT_REACHED :
+            return QLatin1String("Too many path points.");
+        case RESVG_ERROR_IMAGE_BYTES_LIMIT_REACHED :
+            return QLatin1String("Images are too large.");
+        case RESVG_ERROR_TIMEOUT :
+            return QLatin1String("Parsing took too long.");
     }
 
     Q_UNREACHABLE();
 }
 
+static void appendId(void *ids, const char *id)
+{
+    static_cast<QStringList *>(ids)->append(QString::fromUtf8(id));
+}
+
 } //ResvgPrivate
 
+/**
+ * @brief A parsed CSS stylesheet.
+ *
+ * Can be attached to any number of ResvgOptions, so the same stylesheet would be parsed only once.
+ * It's immutable and can be shared between threads.
+ */
+class ResvgStylesheet {
+public:
+    /**
+     * @brief Parses a CSS stylesheet.
+     */
+    explicit ResvgStylesheet(const QString &content)
+        : d(nullptr)
+    {
+        auto contentC = content.toUtf8();
+        contentC.append('\0');
+        d = resvg_stylesheet_create(contentC.constData());
+    }
+
+    /**
+     * @brief Destructs the stylesheet.
+     */
+    ~ResvgStylesheet()
+    {
+        if (d) {
+            resvg_stylesheet_destroy(d);
+        }
+    }
+
+    friend class ResvgOptions;
+
+private:
+    Q_DISABLE_COPY(ResvgStylesheet)
+
+    resvg_stylesheet *d;
+};
+
 /**
  * @brief SVG parsing options.
  */
@@ -138,6 +193,18 @@ public:
         resvg_options_set_dpi(d, dpi);
     }
 
+    /**
+     * @brief Attaches a parsed stylesheet that will be used when resolving CSS attributes.
+     *
+     * The stylesheet can be destroyed afterwards.
+     *
+     * Default: not set
+     */
+    void setStylesheet(const ResvgStylesheet &sheet)
+    {
+        resvg_options_set_compiled_stylesheet(d, sheet.d);
+    }
+
     /**
      * @brief Sets the default font family.
      *
@@ -224,6 +291,48 @@ public:
         resvg_options_set_image_rendering_mode(d, mode);
     }
 
+    /**
+     * @brief Enables raster images decoding at parse time.
+     *
+     * Default: false
+     */
+    void setPreloadImages(const bool preload)
+    {
+        resvg_options_set_preload_images(d, preload);
+    }
+
+    /**
+     * @brief Sets the size of the rendering cache each parsed SVG holds.
+     *
+     * Zero disables the cache.
+     *
+     * Default: 64 MiB
+     */
+    void setCacheSize(const size_t bytes)
+    {
+        resvg_options_set_cache_size(d, bytes);
+    }
+
+    /**
+     * @brief Enables lazy text outlining.
+     *
+     * Default: false
+     */
+    void setLazyText(const bool lazy)
+    {
+        resvg_options_set_lazy_text(d, lazy);
+    }
+
+    /**
+     * @brief Sets resource limits for parsing untrusted SVG data.
+     *
+     * Default: see resvg_limits_default()
+     */
+    void setLimits(const resvg_limits &limits)
+    {
+        resvg_options_set_limits(d, limits);
+    }
+
     /**
      * @brief Loads a font data into the internal fonts database.
      *
@@ -500,14 +609,88 @@ public:
         return QTransform();
     }
 
+    /**
+     * @brief Returns bounding rectangles of all elements with an ID.
+     *
+     * Same as calling #boundsOnElement for each ID, but walks the tree only once.
+     */
+    QHash<QString, QRectF> elementBounds() const
+    {
+        QHash<QString, QRectF> bounds;
+        if (!d->tree)
+            return bounds;
+
+        uintptr_t len = 0;
+        resvg_node_bbox *bboxes = resvg_alloc_all_node_bboxes(d->tree, &len);
+        bounds.reserve(int(len));
+        for (uintptr_t i = 0; i < len; ++i) {
+            const auto &item = bboxes[i];
+            const auto id = QString::fromUtf8(item.id, int(item.id_len));
+            bounds.insert(id, QRectF(item.bbox.x, item.bbox.y, item.bbox.width, item.bbox.height));
+        }
+        resvg_node_bboxes_destroy(bboxes, len);
+
+        return bounds;
+    }
+
+    /**
+     * @brief Returns IDs of elements under a point, in paint order.
+     *
+     * The topmost element is the last one.
+     * When \b exact is set, paths and text are tested against their fill and stroke geometry
+     * instead of their bounding boxes.
+     */
+    QStringList elementsAt(const QPointF &pos, bool exact = true) const
+    {
+        QStringList ids;
+        if (d->tree)
+            resvg_hit_test(d->tree, float(pos.x()), float(pos.y()), exact,
+                           ResvgPrivate::appendId, &ids);
+
+        return ids;
+    }
+
+    /**
+     * @brief Returns IDs of elements intersecting a rectangle, in paint order.
+     *
+     * When \b exact is set, paths and text are tested against their fill and stroke geometry
+     * instead of their bounding boxes.
+     */
+    QStringList elementsIn(const QRectF &rect, bool exact = true) const
+    {
+        QStringList ids;
+        if (d->tree) {
+            const resvg_rect r { float(rect.x()), float(rect.y()),
+                                 float(rect.width()), float(rect.height()) };
+            resvg_query_rect(d->tree, r, exact, ResvgPrivate::appendId, &ids);
+        }
+
+        return ids;
+    }
+
+    /**
+     * @brief Rewrites the underling tree into an equivalent one that is cheaper to render.
+     *
+     * Elements with an ID are preserved.
+     */
+    void optimize()
+    {
+        if (d->tree)
+            resvg_tree_optimize(d->tree);
+    }
+
     // TODO: render node
 
     /**
      * @brief Renders the SVG data to \b QImage with a specified \b size.
      *
      * If \b size is not set, the \b defaultSize() will be used.
+     *
+     * Use \b RESVG_QUALITY_DRAFT for a fast, approximate preview
+     * and \b RESVG_QUALITY_FAST_FILTERS to speed up large blurs.
      */
-    QImage renderToImage(const QSize &size = QSize()) const
+    QImage renderToImage(const QSize &size = QSize(),
+                         const resvg_quality quality = RESVG_QUALITY_NORMAL) const
     {
         resvg_transform ts = resvg_transform_identity();
         if (size.isValid()) {
@@ -524,7 +707,8 @@ public:
 
         QImage qImg(svgSize.width(), svgSize.height(), QImage::Format_ARGB32_Premultiplied);
         qImg.fill(Qt::transparent);
-        resvg_render(d->tree, ts, qImg.width(), qImg.height(), (char*)qImg.bits());
+        resvg_render_with_quality(d->tree, ts, quality, qImg.width(), qImg.height(),
+                                  (char*)qImg.bits());
 
         // resvg renders onto the RGBA canvas, while QImage is ARGB.
         // std::move is required to call inplace version of rgbSwapped().
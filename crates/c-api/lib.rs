@@ -7,8 +7,8 @@
 #![warn(missing_docs)]
 #![warn(missing_copy_implementations)]
 
-use std::ffi::CStr;
-use std::os::raw::c_char;
+use std::ffi::{CStr, CString};
+use std::os::raw::{c_char, c_void};
 use std::slice;
 
 use resvg::tiny_skia;
@@ -26,7 +26,7 @@ pub enum resvg_error {
     FILE_OPEN_FAILED,
     /// Compressed SVG must use the GZip algorithm.
     MALFORMED_GZIP,
-    /// We do not allow SVG with more than 1_000_000 elements for security reasons.
+    /// SVG has more elements than #resvg_limits.max_elements.
     ELEMENTS_LIMIT_REACHED,
     /// SVG doesn't have a valid size.
     ///
@@ -36,6 +36,16 @@ pub enum resvg_error {
     INVALID_SIZE,
     /// Failed to parse an SVG data.
     PARSING_FAILED,
+    /// SVG has more nodes than #resvg_limits.max_nodes after `use` elements expansion.
+    NODES_LIMIT_REACHED,
+    /// SVG elements are nested deeper than #resvg_limits.max_depth.
+    DEPTH_LIMIT_REACHED,
+    /// SVG paths have more points than #resvg_limits.max_path_points.
+    PATH_POINTS_LIMIT_REACHED,
+    /// SVG images are larger than #resvg_limits.max_image_bytes.
+    IMAGE_BYTES_LIMIT_REACHED,
+    /// Parsing took longer than #resvg_limits.timeout_ms.
+    TIMEOUT,
 }
 
 /// @brief A rectangle representation.
@@ -78,6 +88,49 @@ impl resvg_transform {
     }
 }
 
+/// @brief Node's bounding boxes and transform.
+///
+/// All bounding boxes are in canvas coordinates.
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct resvg_node_bbox {
+    /// Node's ID. UTF-8 string. Not NUL-terminated.
+    ///
+    /// Points into the tree and stays valid until it is modified or destroyed.
+    pub id: *const c_char,
+    /// ID length in bytes.
+    pub id_len: usize,
+    /// Object bounding box. See #resvg_get_node_bbox.
+    pub bbox: resvg_rect,
+    /// Bounding box including stroke. See #resvg_get_node_stroke_bbox.
+    pub stroke_bbox: resvg_rect,
+    /// Layer bounding box. Includes filters and children for groups,
+    /// the same as `stroke_bbox` for other nodes.
+    pub layer_bbox: resvg_rect,
+    /// Node's absolute transform. See #resvg_get_node_transform.
+    pub transform: resvg_transform,
+}
+
+/// @brief Resource limits for parsing untrusted SVG data.
+///
+/// Use #resvg_limits_default to get the defaults.
+#[repr(C)]
+#[derive(Copy, Clone)]
+pub struct resvg_limits {
+    /// The maximum number of SVG elements in the XML document. Other namespaces are not counted.
+    pub max_elements: usize,
+    /// The maximum number of nodes after `use` elements are expanded.
+    pub max_nodes: usize,
+    /// The maximum elements nesting depth, including `use` references.
+    pub max_depth: u32,
+    /// The maximum total number of points in all paths, including `use` copies and nested images.
+    pub max_path_points: usize,
+    /// The maximum total size of images data, in bytes, including nested SVG images.
+    pub max_image_bytes: usize,
+    /// The maximum time parsing can take, in milliseconds. Zero means no limit.
+    pub timeout_ms: u32,
+}
+
 /// @brief Creates an identity transform.
 #[no_mangle]
 pub extern "C" fn resvg_transform_identity() -> resvg_transform {
@@ -111,6 +164,8 @@ pub extern "C" fn resvg_init_log() {
 /// The database is empty by default.
 pub struct resvg_options {
     options: usvg::Options<'static>,
+    preload_images: bool,
+    cache_size: usize,
 }
 
 /// @brief Creates a new #resvg_options object.
@@ -120,6 +175,8 @@ pub struct resvg_options {
 pub extern "C" fn resvg_options_create() -> *mut resvg_options {
     Box::into_raw(Box::new(resvg_options {
         options: usvg::Options::default(),
+        preload_images: false,
+        cache_size: resvg::Cache::DEFAULT_MAX_BYTES,
     }))
 }
 
@@ -172,6 +229,65 @@ pub extern "C" fn resvg_options_set_stylesheet(opt: *mut resvg_options, content:
     }
 }
 
+/// @brief A parsed CSS stylesheet.
+///
+/// Can be attached to any number of #resvg_options via #resvg_options_set_compiled_stylesheet,
+/// so the same stylesheet would be parsed only once.
+///
+/// Immutable and can be shared between threads.
+pub struct resvg_stylesheet(std::sync::Arc<usvg::CompiledStyleSheet>);
+
+/// @brief Parses a CSS stylesheet.
+///
+/// @param content Stylesheet content. Must be UTF-8. Must not be NULL.
+/// @return A stylesheet or NULL when `content` is not a UTF-8 string.
+///         Should be destroyed via #resvg_stylesheet_destroy.
+#[no_mangle]
+pub extern "C" fn resvg_stylesheet_create(content: *const c_char) -> *mut resvg_stylesheet {
+    let content = match cstr_to_str(content) {
+        Some(v) => v,
+        None => return std::ptr::null_mut(),
+    };
+
+    let sheet = usvg::CompiledStyleSheet::parse(content);
+    Box::into_raw(Box::new(resvg_stylesheet(std::sync::Arc::new(sheet))))
+}
+
+/// @brief Destroys the #resvg_stylesheet.
+///
+/// Options the stylesheet was attached to are not affected.
+#[no_mangle]
+pub extern "C" fn resvg_stylesheet_destroy(sheet: *mut resvg_stylesheet) {
+    unsafe {
+        assert!(!sheet.is_null());
+        let _ = Box::from_raw(sheet);
+    };
+}
+
+/// @brief Attaches a parsed stylesheet that will be used when resolving CSS attributes.
+///
+/// Works the same way as #resvg_options_set_stylesheet, but without parsing
+/// the stylesheet for each document. Its rules come before the
+/// #resvg_options_set_stylesheet ones.
+///
+/// The stylesheet can be destroyed afterwards.
+///
+/// Can be set to NULL.
+///
+/// Default: NULL
+#[no_mangle]
+pub extern "C" fn resvg_options_set_compiled_stylesheet(
+    opt: *mut resvg_options,
+    sheet: *const resvg_stylesheet,
+) {
+    if sheet.is_null() {
+        cast_opt(opt).compiled_style_sheet = None;
+    } else {
+        let sheet = unsafe { &*sheet };
+        cast_opt(opt).compiled_style_sheet = Some(sheet.0.clone());
+    }
+}
+
 /// @brief Sets the default font family.
 ///
 /// Will be used when no `font-family` attribute is set in the SVG.
@@ -319,6 +435,95 @@ pub extern "C" fn resvg_options_set_languages(opt: *mut resvg_options, languages
     cast_opt(opt).languages = languages;
 }
 
+/// @brief Enables raster images decoding at parse time.
+///
+/// When enabled, all raster images are decoded right after parsing, in parallel,
+/// instead of during the first render.
+/// Images that failed to decode will be reported in the log.
+///
+/// Has no effect when the `raster-images` feature is not enabled.
+///
+/// Default: false
+#[no_mangle]
+pub extern "C" fn resvg_options_set_preload_images(opt: *mut resvg_options, preload: bool) {
+    unsafe {
+        assert!(!opt.is_null());
+        (*opt).preload_images = preload;
+    }
+}
+
+/// @brief Sets the size of the rendering cache each parsed tree holds.
+///
+/// The cache keeps decoded raster images, pattern tiles and nested SVG images
+/// between renders of the same tree. The least recently used results are evicted first.
+///
+/// Zero disables the cache, so each render would start from scratch.
+/// #resvg_options_set_preload_images has no effect in this case.
+///
+/// Default: 64 MiB
+#[no_mangle]
+pub extern "C" fn resvg_options_set_cache_size(opt: *mut resvg_options, bytes: usize) {
+    unsafe {
+        assert!(!opt.is_null());
+        (*opt).cache_size = bytes;
+    }
+}
+
+/// @brief Enables lazy text outlining.
+///
+/// When enabled, text is laid out at parse time, but its glyphs are converted into paths
+/// only when the text is rendered for the first time.
+/// Makes parsing cheaper when only the image size or node bounding boxes are needed.
+/// Stroke bounding boxes of text become approximate.
+///
+/// Has no effect when the `text` feature is not enabled.
+///
+/// Default: false
+#[no_mangle]
+#[allow(unused_variables)]
+pub extern "C" fn resvg_options_set_lazy_text(opt: *mut resvg_options, lazy: bool) {
+    #[cfg(feature = "text")]
+    {
+        cast_opt(opt).lazy_text = lazy;
+    }
+}
+
+/// @brief Returns the default parsing limits.
+///
+/// Path points and images size are unlimited and there is no timeout by default.
+#[no_mangle]
+pub extern "C" fn resvg_limits_default() -> resvg_limits {
+    let limits = usvg::Limits::default();
+    resvg_limits {
+        max_elements: limits.max_elements,
+        max_nodes: limits.max_nodes,
+        max_depth: limits.max_depth,
+        max_path_points: limits.max_path_points,
+        max_image_bytes: limits.max_image_bytes,
+        timeout_ms: 0,
+    }
+}
+
+/// @brief Sets resource limits for parsing untrusted SVG data.
+///
+/// Exceeding any of them makes parsing fail with a corresponding #resvg_error.
+///
+/// Default: see #resvg_limits_default
+#[no_mangle]
+pub extern "C" fn resvg_options_set_limits(opt: *mut resvg_options, limits: resvg_limits) {
+    cast_opt(opt).limits = usvg::Limits {
+        max_elements: limits.max_elements,
+        max_nodes: limits.max_nodes,
+        max_depth: limits.max_depth,
+        max_path_points: limits.max_path_points,
+        max_image_bytes: limits.max_image_bytes,
+        timeout: match limits.timeout_ms {
+            0 => None,
+            ms => Some(std::time::Duration::from_millis(ms as u64)),
+        },
+    };
+}
+
 /// @brief A shape rendering method.
 #[repr(C)]
 #[allow(missing_docs)]
@@ -485,7 +690,26 @@ pub extern "C" fn resvg_options_destroy(opt: *mut resvg_options) {
 
 // TODO: use resvg::Tree
 /// @brief An opaque pointer to the rendering tree.
-pub struct resvg_render_tree(pub usvg::Tree);
+///
+/// Also holds a cache that is shared by all renders of the tree,
+/// unless disabled via #resvg_options_set_cache_size.
+pub struct resvg_render_tree(pub usvg::Tree, pub Option<resvg::Cache>);
+
+fn new_render_tree(tree: usvg::Tree, opt: &resvg_options) -> resvg_render_tree {
+    let cache = match opt.cache_size {
+        0 => None,
+        size => Some(resvg::Cache::new(size)),
+    };
+
+    if let (Some(cache), true) = (&cache, opt.preload_images) {
+        let failed = cache.decode_images(&tree);
+        if failed != 0 {
+            log::warn!("{} raster images failed to decode.", failed);
+        }
+    }
+
+    resvg_render_tree(tree, cache)
+}
 
 /// @brief Creates #resvg_render_tree from file.
 ///
@@ -525,7 +749,7 @@ pub extern "C" fn resvg_parse_tree_from_file(
         Err(e) => return convert_error(e) as i32,
     };
 
-    let tree_box = Box::new(resvg_render_tree(utree));
+    let tree_box = Box::new(new_render_tree(utree, raw_opt));
     unsafe {
         *tree = Box::into_raw(tree_box);
     }
@@ -563,7 +787,7 @@ pub extern "C" fn resvg_parse_tree_from_data(
         Err(e) => return convert_error(e) as i32,
     };
 
-    let tree_box = Box::new(resvg_render_tree(utree));
+    let tree_box = Box::new(new_render_tree(utree, raw_opt));
     unsafe {
         *tree = Box::into_raw(tree_box);
     }
@@ -609,6 +833,44 @@ pub extern "C" fn resvg_get_image_size(tree: *const resvg_render_tree) -> resvg_
     }
 }
 
+/// @brief Returns an approximate amount of memory used by the tree, in bytes.
+///
+/// Includes the parsed tree and the intermediate rendering results cached by it.
+/// Fonts are not included, since they are shared between all trees parsed with the same options.
+///
+/// @param tree Render tree.
+/// @return Memory usage in bytes.
+#[no_mangle]
+pub extern "C" fn resvg_tree_memory_usage(tree: *const resvg_render_tree) -> usize {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    tree.0.memory_usage() + tree.1.as_ref().map_or(0, |cache| cache.memory_usage())
+}
+
+/// @brief Rewrites the tree into an equivalent one that is cheaper to render.
+///
+/// Removes invisible elements and redundant groups and merges adjacent paths with the same fill.
+/// Elements with an ID are preserved, so they can still be queried.
+///
+/// Invalidates intermediate rendering results cached by the tree.
+///
+/// @param tree Render tree.
+#[no_mangle]
+pub extern "C" fn resvg_tree_optimize(tree: *mut resvg_render_tree) {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &mut *tree
+    };
+
+    tree.0.optimize();
+    if let Some(ref cache) = tree.1 {
+        cache.clear();
+    }
+}
+
 /// @brief Returns an object bounding box.
 ///
 /// This bounding box does not include objects stroke and filter regions.
@@ -832,6 +1094,236 @@ fn get_node_bbox(
     }
 }
 
+/// @brief Returns bounding boxes of all nodes with an ID.
+///
+/// Unlike calling #resvg_get_node_bbox for each ID, walks the tree only once.
+///
+/// Nodes are stored in the document order.
+/// When there are more nodes than `len`, only the first `len` are stored.
+/// Pass a NULL `bboxes` to get the number of nodes.
+///
+/// @param tree Render tree.
+/// @param bboxes An array to store bounding boxes to. Can be NULL.
+/// @param len `bboxes` array length.
+/// @return The number of nodes with an ID.
+#[no_mangle]
+pub extern "C" fn resvg_get_all_node_bboxes(
+    tree: *const resvg_render_tree,
+    bboxes: *mut resvg_node_bbox,
+    len: usize,
+) -> usize {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    let bboxes: &mut [resvg_node_bbox] = if bboxes.is_null() {
+        &mut []
+    } else {
+        unsafe { slice::from_raw_parts_mut(bboxes, len) }
+    };
+
+    let mut count = 0;
+    collect_node_bboxes(tree.0.root(), &mut |bbox| {
+        if let Some(item) = bboxes.get_mut(count) {
+            *item = bbox;
+        }
+
+        count += 1;
+    });
+
+    count
+}
+
+/// @brief Returns bounding boxes of all nodes with an ID in a newly allocated array.
+///
+/// Same as #resvg_get_all_node_bboxes, but allocates an array of a required size.
+///
+/// @param tree Render tree.
+/// @param len The number of nodes with an ID. Must not be NULL.
+/// @return An array that must be deallocated using #resvg_node_bboxes_destroy.
+/// @return NULL when there are no nodes with an ID.
+#[no_mangle]
+pub extern "C" fn resvg_alloc_all_node_bboxes(
+    tree: *const resvg_render_tree,
+    len: *mut usize,
+) -> *mut resvg_node_bbox {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    let len = unsafe {
+        assert!(!len.is_null());
+        &mut *len
+    };
+
+    let mut bboxes = Vec::new();
+    collect_node_bboxes(tree.0.root(), &mut |bbox| bboxes.push(bbox));
+
+    *len = bboxes.len();
+    if bboxes.is_empty() {
+        return std::ptr::null_mut();
+    }
+
+    Box::into_raw(bboxes.into_boxed_slice()) as *mut resvg_node_bbox
+}
+
+/// @brief Destroys an array returned by #resvg_alloc_all_node_bboxes.
+///
+/// @param bboxes An array. Can be NULL.
+/// @param len Array length, as returned by #resvg_alloc_all_node_bboxes.
+#[no_mangle]
+pub extern "C" fn resvg_node_bboxes_destroy(bboxes: *mut resvg_node_bbox, len: usize) {
+    if bboxes.is_null() {
+        return;
+    }
+
+    unsafe {
+        let _ = Box::from_raw(std::ptr::slice_from_raw_parts_mut(bboxes, len));
+    };
+}
+
+fn collect_node_bboxes(parent: &usvg::Group, f: &mut dyn FnMut(resvg_node_bbox)) {
+    fn convert_rect(r: usvg::Rect) -> resvg_rect {
+        resvg_rect {
+            x: r.x(),
+            y: r.y(),
+            width: r.width(),
+            height: r.height(),
+        }
+    }
+
+    for node in parent.children() {
+        if !node.id().is_empty() {
+            let ts = node.abs_transform();
+            // Only groups have a dedicated layer bounding box.
+            // For other nodes it's the same as the stroke bounding box.
+            let layer_bbox = match node {
+                usvg::Node::Group(ref group) => group.abs_layer_bounding_box().to_rect(),
+                _ => node.abs_stroke_bounding_box(),
+            };
+
+            f(resvg_node_bbox {
+                id: node.id().as_ptr() as *const c_char,
+                id_len: node.id().len(),
+                bbox: convert_rect(node.abs_bounding_box()),
+                stroke_bbox: convert_rect(node.abs_stroke_bounding_box()),
+                layer_bbox: convert_rect(layer_bbox),
+                transform: resvg_transform {
+                    a: ts.sx,
+                    b: ts.ky,
+                    c: ts.kx,
+                    d: ts.sy,
+                    e: ts.tx,
+                    f: ts.ty,
+                },
+            });
+        }
+
+        if let usvg::Node::Group(ref group) = node {
+            collect_node_bboxes(group, f);
+        }
+    }
+}
+
+/// @brief A callback that receives node IDs.
+///
+/// @param user_data A user data pointer passed to the query function.
+/// @param id Node's ID. UTF-8 string. Valid only during the callback execution.
+pub type resvg_node_callback = Option<extern "C" fn(user_data: *mut c_void, id: *const c_char)>;
+
+/// @brief Finds nodes under a point.
+///
+/// IDs of the found nodes are passed to `callback` in paint order,
+/// i.e. the topmost node is the last one. Nodes without an ID are skipped.
+/// A group is reported before its children and only when any of its children is hit.
+///
+/// Nodes are looked up using a spatial index, which is built on the first use
+/// and shared with rendering.
+///
+/// @param tree Render tree.
+/// @param x Point's X in canvas coordinates.
+/// @param y Point's Y in canvas coordinates.
+/// @param exact Test paths and text against their fill and stroke geometry
+///              instead of their bounding boxes.
+/// @param callback A callback that will receive node IDs. Can be NULL.
+/// @param user_data A pointer that will be passed to `callback`. Can be NULL.
+/// @return The number of found nodes.
+#[no_mangle]
+pub extern "C" fn resvg_hit_test(
+    tree: *const resvg_render_tree,
+    x: f32,
+    y: f32,
+    exact: bool,
+    callback: resvg_node_callback,
+    user_data: *mut c_void,
+) -> u32 {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    report_nodes(tree.0.nodes_at_point(x, y, exact), callback, user_data)
+}
+
+/// @brief Finds nodes intersecting a rectangle.
+///
+/// Nodes are reported the same way as by #resvg_hit_test.
+///
+/// @param tree Render tree.
+/// @param rect A rectangle in canvas coordinates.
+/// @param exact Test paths and text against their fill and stroke geometry
+///              instead of their bounding boxes.
+/// @param callback A callback that will receive node IDs. Can be NULL.
+/// @param user_data A pointer that will be passed to `callback`. Can be NULL.
+/// @return The number of found nodes.
+/// @return 0 when the rectangle has a negative size.
+#[no_mangle]
+pub extern "C" fn resvg_query_rect(
+    tree: *const resvg_render_tree,
+    rect: resvg_rect,
+    exact: bool,
+    callback: resvg_node_callback,
+    user_data: *mut c_void,
+) -> u32 {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    let rect = match usvg::Rect::from_xywh(rect.x, rect.y, rect.width, rect.height) {
+        Some(v) => v,
+        None => return 0,
+    };
+
+    report_nodes(tree.0.nodes_in_rect(rect, exact), callback, user_data)
+}
+
+fn report_nodes(
+    nodes: Vec<&usvg::Node>,
+    callback: resvg_node_callback,
+    user_data: *mut c_void,
+) -> u32 {
+    let mut count = 0;
+    for node in nodes {
+        if node.id().is_empty() {
+            continue;
+        }
+
+        if let Some(callback) = callback {
+            // IDs are taken from XML, so they cannot contain a NUL.
+            if let Ok(id) = CString::new(node.id()) {
+                callback(user_data, id.as_ptr());
+            }
+        }
+
+        count += 1;
+    }
+
+    count
+}
+
 /// @brief Destroys the #resvg_render_tree.
 #[no_mangle]
 pub extern "C" fn resvg_tree_destroy(tree: *mut resvg_render_tree) {
@@ -857,6 +1349,11 @@ fn convert_error(e: usvg::Error) -> resvg_error {
         usvg::Error::ElementsLimitReached => resvg_error::ELEMENTS_LIMIT_REACHED,
         usvg::Error::InvalidSize => resvg_error::INVALID_SIZE,
         usvg::Error::ParsingFailed(_) => resvg_error::PARSING_FAILED,
+        usvg::Error::NodesLimitReached => resvg_error::NODES_LIMIT_REACHED,
+        usvg::Error::DepthLimitReached => resvg_error::DEPTH_LIMIT_REACHED,
+        usvg::Error::PathPointsLimitReached => resvg_error::PATH_POINTS_LIMIT_REACHED,
+        usvg::Error::ImageBytesLimitReached => resvg_error::IMAGE_BYTES_LIMIT_REACHED,
+        usvg::Error::Timeout => resvg_error::TIMEOUT,
     }
 }
 
@@ -886,7 +1383,166 @@ pub extern "C" fn resvg_render(
         unsafe { std::slice::from_raw_parts_mut(pixmap as *mut u8, pixmap_len) };
     let mut pixmap = tiny_skia::PixmapMut::from_bytes(pixmap, width, height).unwrap();
 
-    resvg::render(&tree.0, transform.to_tiny_skia(), &mut pixmap)
+    let options = resvg::RenderOptions {
+        cache: tree.1.as_ref(),
+        ..resvg::RenderOptions::default()
+    };
+    resvg::render_with_options(&tree.0, transform.to_tiny_skia(), &options, &mut pixmap)
+}
+
+/// @brief A rendering quality.
+#[repr(C)]
+#[allow(missing_docs)]
+#[derive(Copy, Clone)]
+pub enum resvg_quality {
+    NORMAL,
+    DRAFT,
+    FAST_FILTERS,
+}
+
+/// @brief Renders the #resvg_render_tree onto the pixmap using the specified quality.
+///
+/// `RESVG_QUALITY_DRAFT` is a fast, approximate mode for previews and thumbnails.
+/// It disables anti-aliasing, approximates blurs, evaluates filters at half resolution
+/// and uses nearest-neighbor sampling for images and patterns.
+///
+/// `RESVG_QUALITY_FAST_FILTERS` keeps the normal quality, but computes large Gaussian blurs
+/// at a reduced resolution, which can differ from the exact result by up to 8 color levels.
+///
+/// @param tree A render tree.
+/// @param transform A root SVG transform. Can be used to position SVG inside the `pixmap`.
+/// @param quality Rendering quality.
+/// @param width Pixmap width.
+/// @param height Pixmap height.
+/// @param pixmap Pixmap data. Should have width*height*4 size and contain
+///               premultiplied RGBA8888 pixels.
+#[no_mangle]
+pub extern "C" fn resvg_render_with_quality(
+    tree: *const resvg_render_tree,
+    transform: resvg_transform,
+    quality: resvg_quality,
+    width: u32,
+    height: u32,
+    pixmap: *mut c_char,
+) {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    let (quality, fast_filters) = match quality as i32 {
+        1 => (resvg::Quality::Draft, false),
+        2 => (resvg::Quality::Normal, true),
+        _ => (resvg::Quality::Normal, false),
+    };
+
+    let pixmap_len = width as usize * height as usize * tiny_skia::BYTES_PER_PIXEL;
+    let pixmap: &mut [u8] =
+        unsafe { std::slice::from_raw_parts_mut(pixmap as *mut u8, pixmap_len) };
+    let mut pixmap = tiny_skia::PixmapMut::from_bytes(pixmap, width, height).unwrap();
+
+    let options = resvg::RenderOptions {
+        quality,
+        fast_filters,
+        cache: tree.1.as_ref(),
+        ..resvg::RenderOptions::default()
+    };
+    resvg::render_with_options(&tree.0, transform.to_tiny_skia(), &options, &mut pixmap)
+}
+
+/// @brief A callback that receives rendered strips.
+///
+/// @param user_data A user data pointer passed to #resvg_render_strips.
+/// @param y Strip's first row in the whole image.
+/// @param height Strip's height. Can be smaller than the requested one for the last strip.
+/// @param pixmap Strip data. Has width*height*4 size and contains premultiplied RGBA8888 pixels.
+///               Valid only during the callback execution.
+pub type resvg_strip_callback =
+    Option<extern "C" fn(user_data: *mut c_void, y: u32, height: u32, pixmap: *const c_char)>;
+
+/// @brief Renders the #resvg_render_tree in horizontal strips.
+///
+/// Produces the same image as #resvg_render, up to a one level difference
+/// on anti-aliased edges, but only a single strip of
+/// `width*strip_height*4` bytes is allocated and reused for each strip.
+/// Layers of filtered groups are still allocated for the whole filter region.
+/// Each rendered strip is passed to `callback`, from top to bottom.
+///
+/// Use it to render huge images without allocating the whole pixmap.
+///
+/// @param tree A render tree.
+/// @param transform A root SVG transform. Can be used to position SVG inside the image.
+/// @param width Image width.
+/// @param height Image height.
+/// @param strip_height Strip height in rows.
+/// @param callback A callback that will receive rendered strips. Must not be NULL.
+/// @param user_data A pointer that will be passed to `callback`. Can be NULL.
+/// @return `false` when the image or the strip size is zero or a strip cannot be allocated.
+#[no_mangle]
+pub extern "C" fn resvg_render_strips(
+    tree: *const resvg_render_tree,
+    transform: resvg_transform,
+    width: u32,
+    height: u32,
+    strip_height: u32,
+    callback: resvg_strip_callback,
+    user_data: *mut c_void,
+) -> bool {
+    let tree = unsafe {
+        assert!(!tree.is_null());
+        &*tree
+    };
+
+    let callback = match callback {
+        Some(v) => v,
+        None => return false,
+    };
+
+    let canvas_size = match tiny_skia::IntSize::from_wh(width, height) {
+        Some(v) => v,
+        None => return false,
+    };
+
+    if strip_height == 0 {
+        return false;
+    }
+
+    let strip_height = strip_height.min(height);
+    let row_len = width as usize * tiny_skia::BYTES_PER_PIXEL;
+    let mut buffer = vec![0u8; row_len * strip_height as usize];
+
+    let options = resvg::RenderOptions {
+        cache: tree.1.as_ref(),
+        ..resvg::RenderOptions::default()
+    };
+
+    let mut y = 0;
+    while y < height {
+        let rows = strip_height.min(height - y);
+        let strip = &mut buffer[..row_len * rows as usize];
+        strip.fill(0);
+
+        {
+            let mut pixmap = match tiny_skia::PixmapMut::from_bytes(strip, width, rows) {
+                Some(v) => v,
+                None => return false,
+            };
+
+            resvg::render_strip_with_options(
+                &tree.0,
+                transform.to_tiny_skia(),
+                canvas_size,
+                y,
+                &options,
+                &mut pixmap,
+            );
+        }
+
+        callback(user_data, y, rows, strip.as_ptr() as *const c_char);
+        y += rows;
+    }
+
+    true
 }
 
 /// @brief Renders a Node by ID onto the image.
@@ -931,7 +1587,12 @@ pub extern "C" fn resvg_render_node(
             unsafe { std::slice::from_raw_parts_mut(pixmap as *mut u8, pixmap_len) };
         let mut pixmap = tiny_skia::PixmapMut::from_bytes(pixmap, width, height).unwrap();
 
-        resvg::render_node(node, transform.to_tiny_skia(), &mut pixmap).is_some()
+        let options = resvg::RenderOptions {
+            cache: tree.1.as_ref(),
+            ..resvg::RenderOptions::default()
+        };
+        resvg::render_node_with_options(node, transform.to_tiny_skia(), &options, &mut pixmap)
+            .is_some()
     } else {
         log::warn!("A node with '{}' ID wasn't found.", id);
         false
@@ -969,3 +1630,63 @@ impl log::Log for SimpleLogger {
 
     fn flush(&self) {}
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn node_bboxes() {
+        let svg = r#"
+        <svg viewBox="0 0 200 200" xmlns="http://www.w3.org/2000/svg">
+            <filter id="blur" x="-1" y="-1" width="3" height="3">
+                <feGaussianBlur stdDeviation="2"/>
+            </filter>
+            <g id="group" filter="url(#blur)">
+                <rect id="rect" x="20" y="20" width="40" height="40"
+                      fill="green" stroke="black" stroke-width="10"/>
+            </g>
+            <rect id="other" x="100" y="100" width="20" height="20"/>
+        </svg>
+        "#;
+
+        let tree = resvg_render_tree(
+            usvg::Tree::from_str(svg, &usvg::Options::default()).unwrap(),
+            None,
+        );
+
+        let mut len = 0;
+        let bboxes = resvg_alloc_all_node_bboxes(&tree, &mut len);
+        assert_eq!(len, 3);
+
+        let items = unsafe { slice::from_raw_parts(bboxes, len) };
+        let find = |id: &str| {
+            items
+                .iter()
+                .find(|b| {
+                    let name = unsafe { slice::from_raw_parts(b.id as *const u8, b.id_len) };
+                    name == id.as_bytes()
+                })
+                .copied()
+                .unwrap()
+        };
+        let xywh = |r: resvg_rect| (r.x, r.y, r.width, r.height);
+
+        // Layer bounding box of a path is its stroke bounding box.
+        let rect = find("rect");
+        assert_eq!(xywh(rect.bbox), (20.0, 20.0, 40.0, 40.0));
+        assert_eq!(xywh(rect.stroke_bbox), (15.0, 15.0, 50.0, 50.0));
+        assert_eq!(xywh(rect.layer_bbox), xywh(rect.stroke_bbox));
+
+        // Layer bounding box of a filtered group is the filter region,
+        // which is relative to the object bounding box.
+        let group = find("group");
+        assert_eq!(xywh(group.stroke_bbox), (15.0, 15.0, 50.0, 50.0));
+        assert_eq!(xywh(group.layer_bbox), (-20.0, -20.0, 120.0, 120.0));
+
+        let other = find("other");
+        assert_eq!(xywh(other.layer_bbox), (100.0, 100.0, 20.0, 20.0));
+
+        resvg_node_bboxes_destroy(bboxes, len);
+    }
+}
@@ -39,7 +39,7 @@ typedef enum {
      */
     RESVG_ERROR_MALFORMED_GZIP,
     /**
-     * We do not allow SVG with more than 1_000_000 elements for security reasons.
+     * SVG has more elements than #resvg_limits.max_elements.
      */
     RESVG_ERROR_ELEMENTS_LIMIT_REACHED,
     /**
@@ -54,6 +54,26 @@ typedef enum {
      * Failed to parse an SVG data.
      */
     RESVG_ERROR_PARSING_FAILED,
+    /**
+     * SVG has more nodes than #resvg_limits.max_nodes after `use` elements expansion.
+     */
+    RESVG_ERROR_NODES_LIMIT_REACHED,
+    /**
+     * SVG elements are nested deeper than #resvg_limits.max_depth.
+     */
+    RESVG_ERROR_DEPTH_LIMIT_REACHED,
+    /**
+     * SVG paths have more points than #resvg_limits.max_path_points.
+     */
+    RESVG_ERROR_PATH_POINTS_LIMIT_REACHED,
+    /**
+     * SVG images are larger than #resvg_limits.max_image_bytes.
+     */
+    RESVG_ERROR_IMAGE_BYTES_LIMIT_REACHED,
+    /**
+     * Parsing took longer than #resvg_limits.timeout_ms.
+     */
+    RESVG_ERROR_TIMEOUT,
 } resvg_error;
 
 /**
@@ -64,6 +84,15 @@ typedef enum {
     RESVG_IMAGE_RENDERING_OPTIMIZE_SPEED,
 } resvg_image_rendering;
 
+/**
+ * @brief A rendering quality.
+ */
+typedef enum {
+    RESVG_QUALITY_NORMAL,
+    RESVG_QUALITY_DRAFT,
+    RESVG_QUALITY_FAST_FILTERS,
+} resvg_quality;
+
 /**
  * @brief A shape rendering method.
  */
@@ -92,9 +121,44 @@ typedef struct resvg_options resvg_options;
 
 /**
  * @brief An opaque pointer to the rendering tree.
+ *
+ * Also holds a cache that is shared by all renders of the tree,
+ * unless disabled via #resvg_options_set_cache_size.
  */
 typedef struct resvg_render_tree resvg_render_tree;
 
+/**
+ * @brief A parsed CSS stylesheet.
+ *
+ * Can be attached to any number of #resvg_options via #resvg_options_set_compiled_stylesheet,
+ * so the same stylesheet would be parsed only once.
+ *
+ * Immutable and can be shared between threads.
+ */
+typedef struct resvg_stylesheet resvg_stylesheet;
+
+/**
+ * @brief A callback that receives rendered strips.
+ *
+ * @param user_data A user data pointer passed to #resvg_render_strips.
+ * @param y Strip's first row in the whole image.
+ * @param height Strip's height. Can be smaller than the requested one for the last strip.
+ * @param pixmap Strip data. Has width*height*4 size and contains premultiplied RGBA8888 pixels.
+ *               Valid only during the callback execution.
+ */
+typedef void (*resvg_strip_callback)(void *user_data,
+                                     uint32_t y,
+                                     uint32_t height,
+                                     const char *pixmap);
+
+/**
+ * @brief A callback that receives node IDs.
+ *
+ * @param user_data A user data pointer passed to the query function.
+ * @param id Node's ID. UTF-8 string. Valid only during the callback execution.
+ */
+typedef void (*resvg_node_callback)(void *user_data, const char *id);
+
 /**
  * @brief A 2D transform representation.
  */
@@ -125,6 +189,73 @@ typedef struct {
     float height;
 } resvg_rect;
 
+/**
+ * @brief Node's bounding boxes and transform.
+ *
+ * All bounding boxes are in canvas coordinates.
+ */
+typedef struct {
+    /**
+     * Node's ID. UTF-8 string. Not NUL-terminated.
+     *
+     * Points into the tree and stays valid until it is modified or destroyed.
+     */
+    const char *id;
+    /**
+     * ID length in bytes.
+     */
+    uintptr_t id_len;
+    /**
+     * Object bounding box. See #resvg_get_node_bbox.
+     */
+    resvg_rect bbox;
+    /**
+     * Bounding box including stroke. See #resvg_get_node_stroke_bbox.
+     */
+    resvg_rect stroke_bbox;
+    /**
+     * Layer bounding box. Includes filters and children for groups,
+     * the same as `stroke_bbox` for other nodes.
+     */
+    resvg_rect layer_bbox;
+    /**
+     * Node's absolute transform. See #resvg_get_node_transform.
+     */
+    resvg_transform transform;
+} resvg_node_bbox;
+
+/**
+ * @brief Resource limits for parsing untrusted SVG data.
+ *
+ * Use #resvg_limits_default to get the defaults.
+ */
+typedef struct {
+    /**
+     * The maximum number of SVG elements in the XML document. Other namespaces are not counted.
+     */
+    uintptr_t max_elements;
+    /**
+     * The maximum number of nodes after `use` elements are expanded.
+     */
+    uintptr_t max_nodes;
+    /**
+     * The maximum elements nesting depth, including `use` references.
+     */
+    uint32_t max_depth;
+    /**
+     * The maximum total number of points in all paths, including `use` copies and nested images.
+     */
+    uintptr_t max_path_points;
+    /**
+     * The maximum total size of images data, in bytes, including nested SVG images.
+     */
+    uintptr_t max_image_bytes;
+    /**
+     * The maximum time parsing can take, in milliseconds. Zero means no limit.
+     */
+    uint32_t timeout_ms;
+} resvg_limits;
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -182,6 +313,37 @@ void resvg_options_set_dpi(resvg_options *opt, float dpi);
  */
 void resvg_options_set_stylesheet(resvg_options *opt, const char *content);
 
+/**
+ * @brief Parses a CSS stylesheet.
+ *
+ * @param content Stylesheet content. Must be UTF-8. Must not be NULL.
+ * @return A stylesheet or NULL when `content` is not a UTF-8 string.
+ *         Should be destroyed via #resvg_stylesheet_destroy.
+ */
+resvg_stylesheet *resvg_stylesheet_create(const char *content);
+
+/**
+ * @brief Destroys the #resvg_stylesheet.
+ *
+ * Options the stylesheet was attached to are not affected.
+ */
+void resvg_stylesheet_destroy(resvg_stylesheet *sheet);
+
+/**
+ * @brief Attaches a parsed stylesheet that will be used when resolving CSS attributes.
+ *
+ * Works the same way as #resvg_options_set_stylesheet, but without parsing
+ * the stylesheet for each document. Its rules come before the
+ * #resvg_options_set_stylesheet ones.
+ *
+ * The stylesheet can be destroyed afterwards.
+ *
+ * Can be set to NULL.
+ *
+ * Default: NULL
+ */
+void resvg_options_set_compiled_stylesheet(resvg_options *opt, const resvg_stylesheet *sheet);
+
 /**
  * @brief Sets the default font family.
  *
@@ -270,6 +432,62 @@ void resvg_options_set_monospace_family(resvg_options *opt, const char *family);
  */
 void resvg_options_set_languages(resvg_options *opt, const char *languages);
 
+/**
+ * @brief Enables raster images decoding at parse time.
+ *
+ * When enabled, all raster images are decoded right after parsing, in parallel,
+ * instead of during the first render.
+ * Images that failed to decode will be reported in the log.
+ *
+ * Has no effect when the `raster-images` feature is not enabled.
+ *
+ * Default: false
+ */
+void resvg_options_set_preload_images(resvg_options *opt, bool preload);
+
+/**
+ * @brief Sets the size of the rendering cache each parsed tree holds.
+ *
+ * The cache keeps decoded raster images, pattern tiles and nested SVG images
+ * between renders of the same tree. The least recently used results are evicted first.
+ *
+ * Zero disables the cache, so each render would start from scratch.
+ * #resvg_options_set_preload_images has no effect in this case.
+ *
+ * Default: 64 MiB
+ */
+void resvg_options_set_cache_size(resvg_options *opt, uintptr_t bytes);
+
+/**
+ * @brief Enables lazy text outlining.
+ *
+ * When enabled, text is laid out at parse time, but its glyphs are converted into paths
+ * only when the text is rendered for the first time.
+ * Makes parsing cheaper when only the image size or node bounding boxes are needed.
+ * Stroke bounding boxes of text become approximate.
+ *
+ * Has no effect when the `text` feature is not enabled.
+ *
+ * Default: false
+ */
+void resvg_options_set_lazy_text(resvg_options *opt, bool lazy);
+
+/**
+ * @brief Returns the default parsing limits.
+ *
+ * Path points and images size are unlimited and there is no timeout by default.
+ */
+resvg_limits resvg_limits_default(void);
+
+/**
+ * @brief Sets resource limits for parsing untrusted SVG data.
+ *
+ * Exceeding any of them makes parsing fail with a corresponding #resvg_error.
+ *
+ * Default: see #resvg_limits_default
+ */
+void resvg_options_set_limits(resvg_options *opt, resvg_limits limits);
+
 /**
  * @brief Sets the default shape rendering method.
  *
@@ -391,6 +609,29 @@ bool resvg_is_image_empty(const resvg_render_tree *tree);
  */
 resvg_size resvg_get_image_size(const resvg_render_tree *tree);
 
+/**
+ * @brief Returns an approximate amount of memory used by the tree, in bytes.
+ *
+ * Includes the parsed tree and the intermediate rendering results cached by it.
+ * Fonts are not included, since they are shared between all trees parsed with the same options.
+ *
+ * @param tree Render tree.
+ * @return Memory usage in bytes.
+ */
+uintptr_t resvg_tree_memory_usage(const resvg_render_tree *tree);
+
+/**
+ * @brief Rewrites the tree into an equivalent one that is cheaper to render.
+ *
+ * Removes invisible elements and redundant groups and merges adjacent paths with the same fill.
+ * Elements with an ID are preserved, so they can still be queried.
+ *
+ * Invalidates intermediate rendering results cached by the tree.
+ *
+ * @param tree Render tree.
+ */
+void resvg_tree_optimize(resvg_render_tree *tree);
+
 /**
  * @brief Returns an object bounding box.
  *
@@ -467,6 +708,90 @@ bool resvg_get_node_bbox(const resvg_render_tree *tree, const char *id, resvg_re
  */
 bool resvg_get_node_stroke_bbox(const resvg_render_tree *tree, const char *id, resvg_rect *bbox);
 
+/**
+ * @brief Returns bounding boxes of all nodes with an ID.
+ *
+ * Unlike calling #resvg_get_node_bbox for each ID, walks the tree only once.
+ *
+ * Nodes are stored in the document order.
+ * When there are more nodes than `len`, only the first `len` are stored.
+ * Pass a NULL `bboxes` to get the number of nodes.
+ *
+ * @param tree Render tree.
+ * @param bboxes An array to store bounding boxes to. Can be NULL.
+ * @param len `bboxes` array length.
+ * @return The number of nodes with an ID.
+ */
+uintptr_t resvg_get_all_node_bboxes(const resvg_render_tree *tree,
+                                    resvg_node_bbox *bboxes,
+                                    uintptr_t len);
+
+/**
+ * @brief Returns bounding boxes of all nodes with an ID in a newly allocated array.
+ *
+ * Same as #resvg_get_all_node_bboxes, but allocates an array of a required size.
+ *
+ * @param tree Render tree.
+ * @param len The number of nodes with an ID. Must not be NULL.
+ * @return An array that must be deallocated using #resvg_node_bboxes_destroy.
+ * @return NULL when there are no nodes with an ID.
+ */
+resvg_node_bbox *resvg_alloc_all_node_bboxes(const resvg_render_tree *tree, uintptr_t *len);
+
+/**
+ * @brief Destroys an array returned by #resvg_alloc_all_node_bboxes.
+ *
+ * @param bboxes An array. Can be NULL.
+ * @param len Array length, as returned by #resvg_alloc_all_node_bboxes.
+ */
+void resvg_node_bboxes_destroy(resvg_node_bbox *bboxes, uintptr_t len);
+
+/**
+ * @brief Finds nodes under a point.
+ *
+ * IDs of the found nodes are passed to `callback` in paint order,
+ * i.e. the topmost node is the last one. Nodes without an ID are skipped.
+ * A group is reported before its children and only when any of its children is hit.
+ *
+ * Nodes are looked up using a spatial index, which is built on the first use
+ * and shared with rendering.
+ *
+ * @param tree Render tree.
+ * @param x Point's X in canvas coordinates.
+ * @param y Point's Y in canvas coordinates.
+ * @param exact Test paths and text against their fill and stroke geometry
+ *              instead of their bounding boxes.
+ * @param callback A callback that will receive node IDs. Can be NULL.
+ * @param user_data A pointer that will be passed to `callback`. Can be NULL.
+ * @return The number of found nodes.
+ */
+uint32_t resvg_hit_test(const resvg_render_tree *tree,
+                        float x,
+                        float y,
+                        bool exact,
+                        resvg_node_callback callback,
+                        void *user_data);
+
+/**
+ * @brief Finds nodes intersecting a rectangle.
+ *
+ * Nodes are reported the same way as by #resvg_hit_test.
+ *
+ * @param tree Render tree.
+ * @param rect A rectangle in canvas coordinates.
+ * @param exact Test paths and text against their fill and stroke geometry
+ *              instead of their bounding boxes.
+ * @param callback A callback that will receive node IDs. Can be NULL.
+ * @param user_data A pointer that will be passed to `callback`. Can be NULL.
+ * @return The number of found nodes.
+ * @return 0 when the rectangle has a negative size.
+ */
+uint32_t resvg_query_rect(const resvg_render_tree *tree,
+                          resvg_rect rect,
+                          bool exact,
+                          resvg_node_callback callback,
+                          void *user_data);
+
 /**
  * @brief Destroys the #resvg_render_tree.
  */
@@ -488,6 +813,59 @@ void resvg_render(const resvg_render_tree *tree,
                   uint32_t height,
                   char *pixmap);
 
+/**
+ * @brief Renders the #resvg_render_tree onto the pixmap using the specified quality.
+ *
+ * `RESVG_QUALITY_DRAFT` is a fast, approximate mode for previews and thumbnails.
+ * It disables anti-aliasing, approximates blurs, evaluates filters at half resolution
+ * and uses nearest-neighbor sampling for images and patterns.
+ *
+ * `RESVG_QUALITY_FAST_FILTERS` keeps the normal quality, but computes large Gaussian blurs
+ * at a reduced resolution, which can differ from the exact result by up to 8 color levels.
+ *
+ * @param tree A render tree.
+ * @param transform A root SVG transform. Can be used to position SVG inside the `pixmap`.
+ * @param quality Rendering quality.
+ * @param width Pixmap width.
+ * @param height Pixmap height.
+ * @param pixmap Pixmap data. Should have width*height*4 size and contain
+ *               premultiplied RGBA8888 pixels.
+ */
+void resvg_render_with_quality(const resvg_render_tree *tree,
+                               resvg_transform transform,
+                               resvg_quality quality,
+                               uint32_t width,
+                               uint32_t height,
+                               char *pixmap);
+
+/**
+ * @brief Renders the #resvg_render_tree in horizontal strips.
+ *
+ * Produces the same image as #resvg_render, up to a one level difference
+ * on anti-aliased edges, but only a single strip of
+ * `width*strip_height*4` bytes is allocated and reused for each strip.
+ * Layers of filtered groups are still allocated for the whole filter region.
+ * Each rendered strip is passed to `callback`, from top to bottom.
+ *
+ * Use it to render huge images without allocating the whole pixmap.
+ *
+ * @param tree A render tree.
+ * @param transform A root SVG transform. Can be used to position SVG inside the image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param strip_height Strip height in rows.
+ * @param callback A callback that will receive rendered strips. Must not be NULL.
+ * @param user_data A pointer that will be passed to `callback`. Can be NULL.
+ * @return `false` when the image or the strip size is zero or a strip cannot be allocated.
+ */
+bool resvg_render_strips(const resvg_render_tree *tree,
+                         resvg_transform transform,
+                         uint32_t width,
+                         uint32_t height,
+                         uint32_t strip_height,
+                         resvg_strip_callback callback,
+                         void *user_data);
+
 /**
  * @brief Renders a Node by ID onto the image.
  *
@@ -0,0 +1,412 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::{Arc, Mutex};
+
+/// A cache of intermediate rendering results.
+///
+/// Stores rendered pattern tiles, rendered nested SVG images,
+/// as well as decoded raster images and their downscaled versions.
+///
+/// Every render uses a temporary cache by default.
+/// Pass the same cache via [`RenderOptions`](crate::RenderOptions) to multiple renders
+/// to reuse results between them, like when redrawing the same tree over and over.
+///
+/// When the cache is full, the least recently used results are evicted first.
+///
+/// Results are bound to the tree nodes they were produced from,
+/// so a cache should not outlive the trees it was used with for too long.
+/// It is safe to share a cache between threads.
+pub struct Cache {
+    max_bytes: usize,
+    inner: Mutex<CacheInner>,
+}
+
+impl Cache {
+    /// The default cache size limit, in bytes.
+    pub const DEFAULT_MAX_BYTES: usize = 64 * 1024 * 1024;
+
+    /// Creates a new cache that can hold up to `max_bytes` of pixel data.
+    pub fn new(max_bytes: usize) -> Self {
+        Cache {
+            max_bytes,
+            inner: Mutex::new(CacheInner::default()),
+        }
+    }
+
+    /// Removes all cached data.
+    pub fn clear(&self) {
+        self.inner.lock().unwrap().clear();
+    }
+
+    /// Returns the amount of pixel data currently stored in the cache, in bytes.
+    pub fn memory_usage(&self) -> usize {
+        self.inner.lock().unwrap().bytes
+    }
+
+    /// Decodes all raster images of a tree upfront.
+    ///
+    /// Images are decoded in parallel, using all available cores,
+    /// so the following renders with this cache would not have to decode them again.
+    /// Decoding stops once the cache is full, without evicting anything,
+    /// so the remaining images would be decoded during rendering.
+    ///
+    /// Returns the number of images that failed to decode.
+    /// Always returns 0 when the `raster-images` feature is disabled.
+    pub fn decode_images(&self, tree: &usvg::Tree) -> usize {
+        crate::image::decode_all(tree, self)
+    }
+
+    pub(crate) fn pattern_tile(&self, key: &PatternKey) -> Option<PatternTile> {
+        let mut inner = self.inner.lock().unwrap();
+        let inner = &mut *inner;
+        let entry = inner.patterns.get_mut(key)?;
+        entry.last_used = inner.lru.touch(entry.last_used, EntryKey::Pattern(*key));
+        Some(entry.tile.clone())
+    }
+
+    pub(crate) fn insert_pattern_tile(
+        &self,
+        key: PatternKey,
+        pattern: Arc<usvg::Pattern>,
+        tile: PatternTile,
+    ) {
+        let size = tile.pixmap.data().len();
+        let mut inner = self.inner.lock().unwrap();
+        if !inner.reserve(size, self.max_bytes, true) {
+            return;
+        }
+
+        let last_used = inner.lru.push(EntryKey::Pattern(key));
+        let entry = PatternEntry {
+            pattern,
+            tile,
+            last_used,
+        };
+        if let Some(prev) = inner.patterns.insert(key, entry) {
+            inner.bytes -= prev.tile.pixmap.data().len();
+            inner.lru.remove(prev.last_used);
+        }
+    }
+
+    pub(crate) fn vector_image(&self, key: &VectorKey) -> Option<VectorTile> {
+        let mut inner = self.inner.lock().unwrap();
+        let inner = &mut *inner;
+        let entry = inner.vectors.get_mut(key)?;
+        entry.last_used = inner.lru.touch(entry.last_used, EntryKey::Vector(*key));
+        Some(entry.tile.clone())
+    }
+
+    pub(crate) fn insert_vector_image(
+        &self,
+        key: VectorKey,
+        tree: Arc<usvg::Tree>,
+        tile: VectorTile,
+    ) {
+        let size = tile.pixmap.data().len();
+        let mut inner = self.inner.lock().unwrap();
+        if !inner.reserve(size, self.max_bytes, true) {
+            return;
+        }
+
+        let last_used = inner.lru.push(EntryKey::Vector(key));
+        let entry = VectorEntry {
+            tree,
+            tile,
+            last_used,
+        };
+        if let Some(prev) = inner.vectors.insert(key, entry) {
+            inner.bytes -= prev.tile.pixmap.data().len();
+            inner.lru.remove(prev.last_used);
+        }
+    }
+
+    /// Returns a decoded raster image or one of its mip levels.
+    ///
+    /// Level 0 is the image itself and each next level is twice as small.
+    #[cfg_attr(not(feature = "raster-images"), allow(dead_code))]
+    pub(crate) fn raster_image(
+        &self,
+        data: &Arc<Vec<u8>>,
+        level: u32,
+    ) -> Option<Arc<tiny_skia::Pixmap>> {
+        let key = ImageKey::new(data, level);
+        let mut inner = self.inner.lock().unwrap();
+        let inner = &mut *inner;
+        let entry = inner.images.get_mut(&key)?;
+        entry.last_used = inner.lru.touch(entry.last_used, EntryKey::Image(key));
+        Some(entry.pixmap.clone())
+    }
+
+    /// Stores a decoded raster image or one of its mip levels.
+    ///
+    /// When `evict` is not set, the image is stored only when there is enough free space.
+    /// Returns `false` when the image was not stored.
+    #[cfg_attr(not(feature = "raster-images"), allow(dead_code))]
+    pub(crate) fn insert_raster_image(
+        &self,
+        data: Arc<Vec<u8>>,
+        level: u32,
+        pixmap: Arc<tiny_skia::Pixmap>,
+        evict: bool,
+    ) -> bool {
+        let size = pixmap.data().len();
+        let mut inner = self.inner.lock().unwrap();
+        if !inner.reserve(size, self.max_bytes, evict) {
+            return false;
+        }
+
+        let key = ImageKey::new(&data, level);
+        let last_used = inner.lru.push(EntryKey::Image(key));
+        let entry = ImageEntry {
+            data,
+            pixmap,
+            last_used,
+        };
+        if let Some(prev) = inner.images.insert(key, entry) {
+            inner.bytes -= prev.pixmap.data().len();
+            inner.lru.remove(prev.last_used);
+        }
+
+        true
+    }
+}
+
+impl Default for Cache {
+    fn default() -> Self {
+        Self::new(Self::DEFAULT_MAX_BYTES)
+    }
+}
+
+impl std::fmt::Debug for Cache {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        f.debug_struct("Cache")
+            .field("max_bytes", &self.max_bytes)
+            .finish()
+    }
+}
+
+#[derive(Default)]
+struct CacheInner {
+    patterns: HashMap<PatternKey, PatternEntry>,
+    vectors: HashMap<VectorKey, VectorEntry>,
+    images: HashMap<ImageKey, ImageEntry>,
+    bytes: usize,
+    lru: Lru,
+}
+
+/// Any cache entry key.
+#[derive(Clone, Copy)]
+enum EntryKey {
+    Pattern(PatternKey),
+    Vector(VectorKey),
+    Image(ImageKey),
+}
+
+impl CacheInner {
+    fn clear(&mut self) {
+        self.patterns.clear();
+        self.vectors.clear();
+        self.images.clear();
+        self.bytes = 0;
+        self.lru.order.clear();
+    }
+
+    /// Accounts for a new entry of the specified size,
+    /// evicting the least recently used entries when needed and allowed.
+    ///
+    /// Returns `false` when the entry doesn't fit.
+    fn reserve(&mut self, size: usize, max_bytes: usize, evict: bool) -> bool {
+        if size > max_bytes {
+            return false;
+        }
+
+        if self.bytes + size > max_bytes {
+            if !evict {
+                return false;
+            }
+
+            self.evict(max_bytes - size);
+        }
+
+        self.bytes += size;
+        true
+    }
+
+    /// Removes the least recently used entries until at most `max_bytes` are used.
+    fn evict(&mut self, max_bytes: usize) {
+        while self.bytes > max_bytes {
+            let key = match self.lru.pop_oldest() {
+                Some(v) => v,
+                None => break,
+            };
+
+            let size = match key {
+                EntryKey::Pattern(ref k) => self.patterns.remove(k).map(|e| e.tile.pixmap),
+                EntryKey::Vector(ref k) => self.vectors.remove(k).map(|e| e.tile.pixmap),
+                EntryKey::Image(ref k) => self.images.remove(k).map(|e| e.pixmap),
+            }
+            .map_or(0, |pixmap| pixmap.data().len());
+            self.bytes -= size;
+        }
+    }
+}
+
+/// Cache entries ordered by their last use.
+///
+/// Each entry stores the stamp of its last use, which is the key in `order`.
+#[derive(Default)]
+struct Lru {
+    order: BTreeMap<u64, EntryKey>,
+    /// Incremented on each access.
+    clock: u64,
+}
+
+impl Lru {
+    /// Adds a new entry and returns its stamp.
+    fn push(&mut self, key: EntryKey) -> u64 {
+        self.clock += 1;
+        self.order.insert(self.clock, key);
+        self.clock
+    }
+
+    /// Marks an entry with the `stamp` as the most recently used one and returns its new stamp.
+    fn touch(&mut self, stamp: u64, key: EntryKey) -> u64 {
+        self.remove(stamp);
+        self.push(key)
+    }
+
+    fn remove(&mut self, stamp: u64) {
+        self.order.remove(&stamp);
+    }
+
+    fn pop_oldest(&mut self) -> Option<EntryKey> {
+        self.order.pop_first().map(|(_, key)| key)
+    }
+}
+
+/// A pattern tile cache key.
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+pub(crate) struct PatternKey {
+    /// `usvg::Pattern` address.
+    pub pattern: usize,
+    /// Tile scale, quantized to 1/1000.
+    pub sx: i32,
+    pub sy: i32,
+    pub draft: bool,
+    pub fast_filters: bool,
+}
+
+impl PatternKey {
+    pub fn new(
+        pattern: &Arc<usvg::Pattern>,
+        sx: f32,
+        sy: f32,
+        draft: bool,
+        fast_filters: bool,
+    ) -> Self {
+        PatternKey {
+            pattern: Arc::as_ptr(pattern) as usize,
+            sx: (sx * 1000.0).round() as i32,
+            sy: (sy * 1000.0).round() as i32,
+            draft,
+            fast_filters,
+        }
+    }
+}
+
+/// A rendered pattern tile.
+#[derive(Clone)]
+pub(crate) struct PatternTile {
+    pub pixmap: Arc<tiny_skia::Pixmap>,
+    /// The scale the tile was rendered at.
+    pub sx: f32,
+    pub sy: f32,
+}
+
+struct PatternEntry {
+    // Keeps the pattern alive, so its address would not be reused by another one.
+    #[allow(dead_code)]
+    pattern: Arc<usvg::Pattern>,
+    tile: PatternTile,
+    last_used: u64,
+}
+
+/// A nested SVG image cache key.
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+pub(crate) struct VectorKey {
+    /// `usvg::Tree` address.
+    pub tree: usize,
+    /// Image scale and subpixel offset, quantized to 1/1000.
+    pub sx: i32,
+    pub sy: i32,
+    pub dx: i32,
+    pub dy: i32,
+    pub draft: bool,
+    pub fast_filters: bool,
+}
+
+impl VectorKey {
+    /// `ts` should not have a skew and its offset should be in the 0..1 range.
+    pub fn new(
+        tree: &Arc<usvg::Tree>,
+        ts: tiny_skia::Transform,
+        draft: bool,
+        fast_filters: bool,
+    ) -> Self {
+        let quantize = |n: f32| (n * 1000.0).round() as i32;
+        VectorKey {
+            tree: Arc::as_ptr(tree) as usize,
+            sx: quantize(ts.sx),
+            sy: quantize(ts.sy),
+            dx: quantize(ts.tx),
+            dy: quantize(ts.ty),
+            draft,
+            fast_filters,
+        }
+    }
+}
+
+/// A rendered nested SVG image.
+#[derive(Clone)]
+pub(crate) struct VectorTile {
+    pub pixmap: Arc<tiny_skia::Pixmap>,
+    /// Tile position relative to the integer part of the image offset.
+    pub x: i32,
+    pub y: i32,
+}
+
+struct VectorEntry {
+    // Keeps the tree alive, so its address would not be reused by another one.
+    #[allow(dead_code)]
+    tree: Arc<usvg::Tree>,
+    tile: VectorTile,
+    last_used: u64,
+}
+
+/// A raster image cache key.
+#[derive(Clone, Copy, PartialEq, Eq, Hash, Debug)]
+struct ImageKey {
+    /// Encoded image data address.
+    data: usize,
+    level: u32,
+}
+
+impl ImageKey {
+    #[cfg_attr(not(feature = "raster-images"), allow(dead_code))]
+    fn new(data: &Arc<Vec<u8>>, level: u32) -> Self {
+        ImageKey {
+            data: Arc::as_ptr(data) as usize,
+            level,
+        }
+    }
+}
+
+struct ImageEntry {
+    // Keeps the data alive, so its address would not be reused by another one.
+    #[allow(dead_code)]
+    data: Arc<Vec<u8>>,
+    pixmap: Arc<tiny_skia::Pixmap>,
+    last_used: u64,
+}
@@ -5,6 +5,7 @@ use crate::render::Context;
 
 pub fn apply(
     clip: &usvg::ClipPath,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::Pixmap,
 ) {
@@ -14,12 +15,13 @@ pub fn apply(
     draw_children(
         clip.root(),
         tiny_skia::BlendMode::Clear,
+        ctx,
         transform.pre_concat(clip.transform()),
         &mut clip_pixmap.as_mut(),
     );
 
     if let Some(clip) = clip.clip_path() {
-        apply(clip, transform, pixmap);
+        apply(clip, ctx, transform, pixmap);
     }
 
     let mut mask = tiny_skia::Mask::from_pixmap(clip_pixmap.as_ref(), tiny_skia::MaskType::Alpha);
@@ -30,6 +32,7 @@ pub fn apply(
 fn draw_children(
     parent: &usvg::Group,
     mode: tiny_skia::BlendMode,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) {
@@ -40,15 +43,10 @@ fn draw_children(
                     continue;
                 }
 
-                // We could use any values here. They will not be used anyway.
-                let ctx = Context {
-                    max_bbox: tiny_skia::IntRect::from_xywh(0, 0, 1, 1).unwrap(),
-                };
-
-                crate::path::fill_path(path, mode, &ctx, transform, pixmap);
+                crate::path::fill_path(path, mode, usvg::Opacity::ONE, ctx, transform, pixmap);
             }
             usvg::Node::Text(ref text) => {
-                draw_children(text.flattened(), mode, transform, pixmap);
+                draw_children(text.flattened(), mode, ctx, transform, pixmap);
             }
             usvg::Node::Group(ref group) => {
                 let transform = transform.pre_concat(group.transform());
@@ -57,9 +55,9 @@ fn draw_children(
                     // If a `clipPath` child also has a `clip-path`
                     // then we should render this child on a new canvas,
                     // clip it, and only then draw it to the `clipPath`.
-                    clip_group(group, clip, transform, pixmap);
+                    clip_group(group, clip, ctx, transform, pixmap);
                 } else {
-                    draw_children(group, mode, transform, pixmap);
+                    draw_children(group, mode, ctx, transform, pixmap);
                 }
             }
             _ => {}
@@ -70,6 +68,7 @@ fn draw_children(
 fn clip_group(
     children: &usvg::Group,
     clip: &usvg::ClipPath,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) -> Option<()> {
@@ -78,10 +77,11 @@ fn clip_group(
     draw_children(
         children,
         tiny_skia::BlendMode::SourceOver,
+        ctx,
         transform,
         &mut clip_pixmap.as_mut(),
     );
-    apply(clip, transform, &mut clip_pixmap);
+    apply(clip, ctx, transform, &mut clip_pixmap);
 
     let mut paint = tiny_skia::PixmapPaint::default();
     paint.blend_mode = tiny_skia::BlendMode::Xor;
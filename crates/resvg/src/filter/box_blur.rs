@@ -33,6 +33,74 @@ pub fn apply(sigma_x: f64, sigma_y: f64, mut src: ImageRefMut) {
     }
 }
 
+/// Applies a single box blur pass approximating a Gaussian blur.
+///
+/// Much faster than [`apply`], but also much less accurate.
+///
+/// Input image pixels should have a **premultiplied alpha**.
+///
+/// # Allocations
+///
+/// This method will allocate a copy of the `src` image as a back buffer.
+pub fn apply_single_pass(sigma_x: f64, sigma_y: f64, mut src: ImageRefMut) {
+    let radius_horz = single_box_radius(sigma_x as f32);
+    let radius_vert = single_box_radius(sigma_y as f32);
+    let mut backbuf = src.data.to_vec();
+    let mut backbuf = ImageRefMut::new(src.width, src.height, &mut backbuf);
+
+    box_blur_impl(radius_horz, radius_vert, &mut backbuf, &mut src);
+}
+
+/// Applies a box blur to an alpha mask.
+///
+/// Produces the same result as [`apply`] does for the alpha channel.
+///
+/// # Allocations
+///
+/// This method will allocate a copy of the `alpha` mask as a back buffer.
+pub fn apply_alpha(sigma_x: f64, sigma_y: f64, width: u32, height: u32, alpha: &mut [u8]) {
+    let boxes_horz = create_box_gauss(sigma_x as f32);
+    let boxes_vert = create_box_gauss(sigma_y as f32);
+    let mut backbuf = alpha.to_vec();
+
+    for (box_size_horz, box_size_vert) in boxes_horz.iter().zip(boxes_vert.iter()) {
+        let radius_horz = ((box_size_horz - 1) / 2) as usize;
+        let radius_vert = ((box_size_vert - 1) / 2) as usize;
+        box_blur_alpha_impl(radius_horz, radius_vert, width, height, &mut backbuf, alpha);
+    }
+}
+
+/// Same as [`apply_single_pass`], but for an alpha mask.
+///
+/// # Allocations
+///
+/// This method will allocate a copy of the `alpha` mask as a back buffer.
+pub fn apply_single_pass_alpha(
+    sigma_x: f64,
+    sigma_y: f64,
+    width: u32,
+    height: u32,
+    alpha: &mut [u8],
+) {
+    let radius_horz = single_box_radius(sigma_x as f32);
+    let radius_vert = single_box_radius(sigma_y as f32);
+    let mut backbuf = alpha.to_vec();
+
+    box_blur_alpha_impl(radius_horz, radius_vert, width, height, &mut backbuf, alpha);
+}
+
+/// Returns the radius of a box with the same variance as a Gaussian with the provided sigma.
+///
+/// A box of width `w` has a variance of `(w^2 - 1) / 12`.
+fn single_box_radius(sigma: f32) -> usize {
+    if sigma > 0.0 {
+        let w = (12.0 * sigma * sigma + 1.0).sqrt();
+        ((w - 1.0) / 2.0).round() as usize
+    } else {
+        0
+    }
+}
+
 #[inline(never)]
 fn create_box_gauss(sigma: f32) -> [i32; STEPS] {
     if sigma > 0.0 {
@@ -335,6 +403,70 @@ fn box_blur_horz(blur_radius: usize, backbuf: &ImageRefMut, frontbuf: &mut Image
     }
 }
 
+/// Same as `box_blur_impl`, but for an alpha mask.
+fn box_blur_alpha_impl(
+    blur_radius_horz: usize,
+    blur_radius_vert: usize,
+    width: u32,
+    height: u32,
+    backbuf: &mut [u8],
+    frontbuf: &mut [u8],
+) {
+    let width = width as usize;
+    let height = height as usize;
+
+    for x in 0..width {
+        box_blur_line(blur_radius_vert, frontbuf, backbuf, x, width, height);
+    }
+
+    for y in 0..height {
+        box_blur_line(blur_radius_horz, backbuf, frontbuf, y * width, 1, width);
+    }
+}
+
+/// Blurs a single row or column of an alpha mask.
+///
+/// Pixels outside the line are treated as transparent, like in `box_blur_horz`.
+fn box_blur_line(
+    blur_radius: usize,
+    backbuf: &[u8],
+    frontbuf: &mut [u8],
+    start: usize,
+    stride: usize,
+    len: usize,
+) {
+    let get = |i: usize| -> isize {
+        if i < len {
+            backbuf[start + i * stride] as isize
+        } else {
+            0
+        }
+    };
+
+    if blur_radius == 0 {
+        for i in 0..len {
+            frontbuf[start + i * stride] = backbuf[start + i * stride];
+        }
+        return;
+    }
+
+    let iarr = 1.0 / (blur_radius + blur_radius + 1) as f32;
+
+    let mut val: isize = 0;
+    for i in 0..cmp::min(blur_radius, len) {
+        val += get(i);
+    }
+
+    for i in 0..len {
+        val += get(i + blur_radius);
+        frontbuf[start + i * stride] = round(val as f32 * iarr) as u8;
+
+        if i >= blur_radius {
+            val -= get(i - blur_radius);
+        }
+    }
+}
+
 /// Fast rounding for x <= 2^23.
 /// This is orders of magnitude faster than built-in rounding intrinsic.
 ///
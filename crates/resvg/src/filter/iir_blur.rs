@@ -65,6 +65,31 @@ pub fn apply(sigma_x: f64, sigma_y: f64, src: ImageRefMut) {
     gaussian_channel(data, &d, 3, buf);
 }
 
+/// Applies an IIR blur to an alpha mask.
+///
+/// Produces the same result as [`apply`] does for the alpha channel.
+///
+/// # Allocations
+///
+/// This method will allocate an 8x `alpha` buffer.
+pub fn apply_alpha(sigma_x: f64, sigma_y: f64, width: u32, height: u32, alpha: &mut [u8]) {
+    let d = BlurData {
+        width: width as usize,
+        height: height as usize,
+        sigma_x,
+        sigma_y,
+        steps: 4,
+    };
+
+    let mut buf: Vec<f64> = alpha.iter().map(|a| *a as f64 / 255.0).collect();
+
+    gaussianiir2d(&d, &mut buf);
+
+    for (a, v) in alpha.iter_mut().zip(buf.iter()) {
+        *a = (v * 255.0) as u8;
+    }
+}
+
 fn gaussian_channel(data: &mut [u8], d: &BlurData, channel: usize, buf: &mut [f64]) {
     for i in 0..data.len() / 4 {
         buf[i] = data[i * 4 + channel] as f64 / 255.0;
@@ -1,12 +1,15 @@
 // Copyright 2018 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
+use std::cell::RefCell;
 use std::rc::Rc;
 
 use rgb::{FromSlice, RGBA8};
 use tiny_skia::IntRect;
 use usvg::{ApproxEqUlps, ApproxZeroUlps};
 
+use crate::render::Context;
+
 mod box_blur;
 mod color_matrix;
 mod component_transfer;
@@ -16,6 +19,7 @@ mod displacement_map;
 mod iir_blur;
 mod lighting;
 mod morphology;
+mod multiscale_blur;
 mod turbulence;
 
 // TODO: apply single primitive filters in-place
@@ -95,6 +99,7 @@ trait PixmapExt: Sized {
     fn clear(&mut self);
     fn into_srgb(&mut self);
     fn into_linear_rgb(&mut self);
+    fn convert_to(&mut self, color_space: usvg::filter::ColorInterpolation);
 }
 
 impl PixmapExt for tiny_skia::Pixmap {
@@ -113,15 +118,49 @@ impl PixmapExt for tiny_skia::Pixmap {
     }
 
     fn into_srgb(&mut self) {
-        demultiply_alpha(self.data_mut().as_rgba_mut());
-        from_linear_rgb(self.data_mut().as_rgba_mut());
-        multiply_alpha(self.data_mut().as_rgba_mut());
+        convert_color_space(self.data_mut().as_rgba_mut(), &LINEAR_RGB_TO_SRGB_TABLE);
     }
 
     fn into_linear_rgb(&mut self) {
-        demultiply_alpha(self.data_mut().as_rgba_mut());
-        into_linear_rgb(self.data_mut().as_rgba_mut());
-        multiply_alpha(self.data_mut().as_rgba_mut());
+        convert_color_space(self.data_mut().as_rgba_mut(), &SRGB_TO_LINEAR_RGB_TABLE);
+    }
+
+    fn convert_to(&mut self, color_space: usvg::filter::ColorInterpolation) {
+        match color_space {
+            usvg::filter::ColorInterpolation::SRGB => self.into_srgb(),
+            usvg::filter::ColorInterpolation::LinearRGB => self.into_linear_rgb(),
+        }
+    }
+}
+
+/// Converts premultiplied pixels using a color space conversion table.
+///
+/// Same as demultiplying, converting and multiplying pixels,
+/// but in a single pass and with a fast path for opaque and transparent pixels.
+fn convert_color_space(data: &mut [RGBA8], table: &[u8; 256]) {
+    for p in data {
+        match p.a {
+            0 => {
+                p.r = 0;
+                p.g = 0;
+                p.b = 0;
+            }
+            255 => {
+                p.r = table[p.r as usize];
+                p.g = table[p.g as usize];
+                p.b = table[p.b as usize];
+            }
+            _ => {
+                let a = p.a as f32 / 255.0;
+                let convert = |c: u8| {
+                    let c = (c as f32 / a + 0.5) as u8;
+                    (table[c as usize] as f32 * a + 0.5) as u8
+                };
+                p.r = convert(p.r);
+                p.g = convert(p.g);
+                p.b = convert(p.b);
+            }
+        }
     }
 }
 
@@ -271,40 +310,68 @@ struct Image {
 
     /// The current color space.
     color_space: usvg::filter::ColorInterpolation,
+
+    /// The same image in the other color space.
+    ///
+    /// Shared between all clones, so a result used by multiple primitives
+    /// would be converted only once.
+    converted: Rc<RefCell<Option<Rc<tiny_skia::Pixmap>>>>,
 }
 
 impl Image {
-    fn from_image(image: tiny_skia::Pixmap, color_space: usvg::filter::ColorInterpolation) -> Self {
-        let (w, h) = (image.width(), image.height());
+    fn new(
+        image: tiny_skia::Pixmap,
+        region: IntRect,
+        color_space: usvg::filter::ColorInterpolation,
+    ) -> Self {
         Image {
             image: Rc::new(image),
-            region: IntRect::from_xywh(0, 0, w, h).unwrap(),
+            region,
             color_space,
+            converted: Rc::default(),
         }
     }
 
+    fn from_image(image: tiny_skia::Pixmap, color_space: usvg::filter::ColorInterpolation) -> Self {
+        let (w, h) = (image.width(), image.height());
+        Image::new(image, IntRect::from_xywh(0, 0, w, h).unwrap(), color_space)
+    }
+
     fn into_color_space(
         self,
         color_space: usvg::filter::ColorInterpolation,
     ) -> Result<Self, Error> {
-        if color_space != self.color_space {
-            let region = self.region;
-
-            let mut image = self.take()?;
+        if color_space == self.color_space {
+            return Ok(self);
+        }
 
-            match color_space {
-                usvg::filter::ColorInterpolation::SRGB => image.into_srgb(),
-                usvg::filter::ColorInterpolation::LinearRGB => image.into_linear_rgb(),
-            }
+        let region = self.region;
 
-            Ok(Image {
-                image: Rc::new(image),
+        // Already converted for another primitive.
+        if let Some(image) = self.converted.borrow().clone() {
+            return Ok(Image {
+                image,
                 region,
                 color_space,
-            })
-        } else {
-            Ok(self)
+                converted: Rc::default(),
+            });
         }
+
+        let mut image = self.take()?;
+        image.convert_to(color_space);
+        Ok(Image::new(image, region, color_space))
+    }
+
+    /// Converts the image into the specified color space in advance,
+    /// so it would not be converted again by each primitive that uses it.
+    fn cache_color_space(&self, color_space: usvg::filter::ColorInterpolation) {
+        if color_space == self.color_space || self.converted.borrow().is_some() {
+            return;
+        }
+
+        let mut image = (*self.image).clone();
+        image.convert_to(color_space);
+        *self.converted.borrow_mut() = Some(Rc::new(image));
     }
 
     fn take(self) -> Result<tiny_skia::Pixmap, Error> {
@@ -334,11 +401,15 @@ struct FilterResult {
 
 pub fn apply(
     filter: &usvg::filter::Filter,
+    ctx: &Context,
     ts: tiny_skia::Transform,
     source: &mut tiny_skia::Pixmap,
 ) {
-    let result = apply_inner(filter, ts, source);
-    let result = result.and_then(|image| apply_to_canvas(image, source));
+    let result = if ctx.is_draft() {
+        apply_draft(filter, ctx, ts, source)
+    } else {
+        apply_inner(filter, ctx, ts, source).and_then(|image| apply_to_canvas(image, source))
+    };
 
     // Clear on error.
     if result.is_err() {
@@ -354,8 +425,53 @@ pub fn apply(
     }
 }
 
+/// Applies a filter at half resolution.
+///
+/// The source is downscaled by 2, filtered using a scaled transform
+/// and then upscaled back.
+fn apply_draft(
+    filter: &usvg::filter::Filter,
+    ctx: &Context,
+    ts: tiny_skia::Transform,
+    source: &mut tiny_skia::Pixmap,
+) -> Result<(), Error> {
+    let width = (source.width() + 1) / 2;
+    let height = (source.height() + 1) / 2;
+
+    let paint = tiny_skia::PixmapPaint {
+        quality: tiny_skia::FilterQuality::Bilinear,
+        ..tiny_skia::PixmapPaint::default()
+    };
+
+    let mut half = tiny_skia::Pixmap::try_create(width, height)?;
+    half.draw_pixmap(
+        0,
+        0,
+        source.as_ref(),
+        &paint,
+        tiny_skia::Transform::from_scale(0.5, 0.5),
+        None,
+    );
+
+    let image = apply_inner(filter, ctx, ts.post_scale(0.5, 0.5), &mut half)?;
+    apply_to_canvas(image, &mut half)?;
+
+    source.fill(tiny_skia::Color::TRANSPARENT);
+    source.draw_pixmap(
+        0,
+        0,
+        half.as_ref(),
+        &paint,
+        tiny_skia::Transform::from_scale(2.0, 2.0),
+        None,
+    );
+
+    Ok(())
+}
+
 fn apply_inner(
     filter: &usvg::filter::Filter,
+    ctx: &Context,
     ts: usvg::Transform,
     source: &mut tiny_skia::Pixmap,
 ) -> Result<Image, Error> {
@@ -366,8 +482,10 @@ fn apply_inner(
         .ok_or(Error::InvalidRegion)?;
 
     let mut results: Vec<FilterResult> = Vec::new();
+    let source = SourceImages::new(source, region);
 
-    for primitive in filter.primitives() {
+    let primitives = filter.primitives();
+    for (i, primitive) in primitives.iter().enumerate() {
         let mut subregion = primitive
             .rect()
             .transform(ts)
@@ -385,64 +503,66 @@ fn apply_inner(
 
         let cs = primitive.color_interpolation();
 
+        cache_shared_inputs(primitive, &primitives[i + 1..], region, &source, &results)?;
+
         let mut result = match primitive.kind() {
             usvg::filter::Kind::Blend(ref fe) => {
-                let input1 = get_input(fe.input1(), region, source, &results)?;
-                let input2 = get_input(fe.input2(), region, source, &results)?;
+                let input1 = get_input(fe.input1(), region, &source, &results)?;
+                let input2 = get_input(fe.input2(), region, &source, &results)?;
                 apply_blend(fe, cs, region, input1, input2)
             }
             usvg::filter::Kind::DropShadow(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
-                apply_drop_shadow(fe, cs, ts, input)
+                let input = get_input(fe.input(), region, &source, &results)?;
+                apply_drop_shadow(fe, ctx, cs, ts, input)
             }
             usvg::filter::Kind::Flood(ref fe) => apply_flood(fe, region),
             usvg::filter::Kind::GaussianBlur(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
-                apply_blur(fe, cs, ts, input)
+                let input = get_input(fe.input(), region, &source, &results)?;
+                apply_blur(fe, ctx, cs, ts, input)
             }
             usvg::filter::Kind::Offset(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_offset(fe, ts, input)
             }
             usvg::filter::Kind::Composite(ref fe) => {
-                let input1 = get_input(fe.input1(), region, source, &results)?;
-                let input2 = get_input(fe.input2(), region, source, &results)?;
+                let input1 = get_input(fe.input1(), region, &source, &results)?;
+                let input2 = get_input(fe.input2(), region, &source, &results)?;
                 apply_composite(fe, cs, region, input1, input2)
             }
-            usvg::filter::Kind::Merge(ref fe) => apply_merge(fe, cs, region, source, &results),
+            usvg::filter::Kind::Merge(ref fe) => apply_merge(fe, cs, region, &source, &results),
             usvg::filter::Kind::Tile(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_tile(input, region)
             }
-            usvg::filter::Kind::Image(ref fe) => apply_image(fe, region, subregion, ts),
+            usvg::filter::Kind::Image(ref fe) => apply_image(fe, ctx, region, subregion, ts),
             usvg::filter::Kind::ComponentTransfer(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_component_transfer(fe, cs, input)
             }
             usvg::filter::Kind::ColorMatrix(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_color_matrix(fe, cs, input)
             }
             usvg::filter::Kind::ConvolveMatrix(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_convolve_matrix(fe, cs, input)
             }
             usvg::filter::Kind::Morphology(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_morphology(fe, cs, ts, input)
             }
             usvg::filter::Kind::DisplacementMap(ref fe) => {
-                let input1 = get_input(fe.input1(), region, source, &results)?;
-                let input2 = get_input(fe.input2(), region, source, &results)?;
+                let input1 = get_input(fe.input1(), region, &source, &results)?;
+                let input2 = get_input(fe.input2(), region, &source, &results)?;
                 apply_displacement_map(fe, region, cs, ts, input1, input2)
             }
             usvg::filter::Kind::Turbulence(ref fe) => apply_turbulence(fe, region, cs, ts),
             usvg::filter::Kind::DiffuseLighting(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_diffuse_lighting(fe, region, cs, ts, input)
             }
             usvg::filter::Kind::SpecularLighting(ref fe) => {
-                let input = get_input(fe.input(), region, source, &results)?;
+                let input = get_input(fe.input(), region, &source, &results)?;
                 apply_specular_lighting(fe, region, cs, ts, input)
             }
         }?;
@@ -493,11 +613,7 @@ fn apply_inner(
                 pixmap
             };
 
-            result = Image {
-                image: Rc::new(pixmap),
-                region: subregion,
-                color_space,
-            };
+            result = Image::new(pixmap, subregion, color_space);
         }
 
         results.push(FilterResult {
@@ -516,34 +632,12 @@ fn apply_inner(
 fn get_input(
     input: &usvg::filter::Input,
     region: IntRect,
-    source: &tiny_skia::Pixmap,
+    source: &SourceImages,
     results: &[FilterResult],
 ) -> Result<Image, Error> {
     match input {
-        usvg::filter::Input::SourceGraphic => {
-            let image = source.clone();
-
-            Ok(Image {
-                image: Rc::new(image),
-                region,
-                color_space: usvg::filter::ColorInterpolation::SRGB,
-            })
-        }
-        usvg::filter::Input::SourceAlpha => {
-            let mut image = source.clone();
-            // Set RGB to black. Keep alpha as is.
-            for p in image.data_mut().as_rgba_mut() {
-                p.r = 0;
-                p.g = 0;
-                p.b = 0;
-            }
-
-            Ok(Image {
-                image: Rc::new(image),
-                region,
-                color_space: usvg::filter::ColorInterpolation::SRGB,
-            })
-        }
+        usvg::filter::Input::SourceGraphic => Ok(source.get(false)),
+        usvg::filter::Input::SourceAlpha => Ok(source.get(true)),
         usvg::filter::Input::Reference(ref name) => {
             if let Some(v) = results.iter().rev().find(|v| v.name == *name) {
                 Ok(v.image.clone())
@@ -556,6 +650,98 @@ fn get_input(
     }
 }
 
+/// Converts inputs that are used by later primitives as well in advance,
+/// so they would be converted only once.
+fn cache_shared_inputs(
+    primitive: &usvg::filter::Primitive,
+    later: &[usvg::filter::Primitive],
+    region: IntRect,
+    source: &SourceImages,
+    results: &[FilterResult],
+) -> Result<(), Error> {
+    // These primitives do not care about the input color space.
+    if let usvg::filter::Kind::Offset(..) | usvg::filter::Kind::Tile(..) = primitive.kind() {
+        return Ok(());
+    }
+
+    let mut inputs = vec![
+        usvg::filter::Input::SourceGraphic,
+        usvg::filter::Input::SourceAlpha,
+    ];
+    inputs.extend(
+        results
+            .iter()
+            .map(|v| usvg::filter::Input::Reference(v.name.clone())),
+    );
+
+    for input in inputs {
+        if primitive.kind().has_input(&input) && later.iter().any(|p| p.kind().has_input(&input)) {
+            let image = match input {
+                usvg::filter::Input::SourceGraphic => source.keep(false),
+                usvg::filter::Input::SourceAlpha => source.keep(true),
+                usvg::filter::Input::Reference(..) => get_input(&input, region, source, results)?,
+            };
+            image.cache_color_space(primitive.color_interpolation());
+        }
+    }
+
+    Ok(())
+}
+
+/// `SourceGraphic` and `SourceAlpha` images of a filter.
+struct SourceImages<'a> {
+    pixmap: &'a tiny_skia::Pixmap,
+    region: IntRect,
+    graphic: RefCell<Option<Image>>,
+    alpha: RefCell<Option<Image>>,
+}
+
+impl<'a> SourceImages<'a> {
+    fn new(pixmap: &'a tiny_skia::Pixmap, region: IntRect) -> Self {
+        SourceImages {
+            pixmap,
+            region,
+            graphic: RefCell::new(None),
+            alpha: RefCell::new(None),
+        }
+    }
+
+    /// Returns a kept source image or creates a new one.
+    fn get(&self, alpha: bool) -> Image {
+        let kept = self.cell(alpha).borrow().clone();
+        kept.unwrap_or_else(|| self.create(alpha))
+    }
+
+    /// Keeps a source image for the following primitives,
+    /// instead of creating it for each of them.
+    fn keep(&self, alpha: bool) -> Image {
+        let mut kept = self.cell(alpha).borrow_mut();
+        kept.get_or_insert_with(|| self.create(alpha)).clone()
+    }
+
+    fn cell(&self, alpha: bool) -> &RefCell<Option<Image>> {
+        if alpha {
+            &self.alpha
+        } else {
+            &self.graphic
+        }
+    }
+
+    fn create(&self, alpha: bool) -> Image {
+        let mut image = self.pixmap.clone();
+        if alpha {
+            // Set RGB to black. Keep alpha as is.
+            for p in image.data_mut().as_rgba_mut() {
+                p.r = 0;
+                p.g = 0;
+                p.b = 0;
+            }
+        }
+
+        Image::new(image, self.region, usvg::filter::ColorInterpolation::SRGB)
+    }
+}
+
 trait PixmapToImageRef<'a> {
     fn as_image_ref(&'a self) -> ImageRef<'a>;
     fn as_image_ref_mut(&'a mut self) -> ImageRefMut<'a>;
@@ -573,6 +759,7 @@ impl<'a> PixmapToImageRef<'a> for tiny_skia::Pixmap {
 
 fn apply_drop_shadow(
     fe: &usvg::filter::DropShadow,
+    ctx: &Context,
     cs: usvg::filter::ColorInterpolation,
     ts: usvg::Transform,
     input: Image,
@@ -582,46 +769,60 @@ fn apply_drop_shadow(
         None => return Ok(input),
     };
 
-    let mut pixmap = tiny_skia::Pixmap::try_create(input.width(), input.height())?;
     let input_pixmap = input.into_color_space(cs)?.take()?;
-    let mut shadow_pixmap = input_pixmap.clone();
+    let width = input_pixmap.width();
+    let height = input_pixmap.height();
 
+    // The shadow color is constant, so only the alpha has to be blurred.
+    let mut alpha: Vec<u8> = input_pixmap.pixels().iter().map(|p| p.alpha()).collect();
     if let Some((std_dx, std_dy, use_box_blur)) =
         resolve_std_dev(fe.std_dev_x().get(), fe.std_dev_y().get(), ts)
     {
-        if use_box_blur {
-            box_blur::apply(std_dx, std_dy, shadow_pixmap.as_image_ref_mut());
-        } else {
-            iir_blur::apply(std_dx, std_dy, shadow_pixmap.as_image_ref_mut());
-        }
+        blur_alpha(ctx, std_dx, std_dy, use_box_blur, width, height, &mut alpha);
     }
 
-    // flood
+    // Flood and color space conversion depend only on the alpha as well.
     let color = tiny_skia::Color::from_rgba8(
         fe.color().red,
         fe.color().green,
         fe.color().blue,
         fe.opacity().to_u8(),
     );
-    for p in shadow_pixmap.pixels_mut() {
-        let mut color = color;
-        color.apply_opacity(p.alpha() as f32 / 255.0);
-        *p = color.premultiply().to_color_u8();
-    }
-
+    let mut shadow_colors: Vec<RGBA8> = (0..=255u8)
+        .map(|a| {
+            let mut color = color;
+            color.apply_opacity(a as f32 / 255.0);
+            let c = color.premultiply().to_color_u8();
+            RGBA8::new(c.red(), c.green(), c.blue(), c.alpha())
+        })
+        .collect();
+    demultiply_alpha(&mut shadow_colors);
     match cs {
-        usvg::filter::ColorInterpolation::SRGB => shadow_pixmap.into_srgb(),
-        usvg::filter::ColorInterpolation::LinearRGB => shadow_pixmap.into_linear_rgb(),
+        usvg::filter::ColorInterpolation::SRGB => from_linear_rgb(&mut shadow_colors),
+        usvg::filter::ColorInterpolation::LinearRGB => into_linear_rgb(&mut shadow_colors),
     }
+    multiply_alpha(&mut shadow_colors);
+
+    // Offset and colorize the shadow in a single pass and draw the source over it.
+    let mut pixmap = tiny_skia::Pixmap::try_create(width, height)?;
+    let (dx, dy) = (dx as i32, dy as i32);
+    let data = pixmap.data_mut().as_rgba_mut();
+    for y in 0..height as i32 {
+        let sy = y - dy;
+        if sy < 0 || sy >= height as i32 {
+            continue;
+        }
 
-    pixmap.draw_pixmap(
-        dx as i32,
-        dy as i32,
-        shadow_pixmap.as_ref(),
-        &tiny_skia::PixmapPaint::default(),
-        tiny_skia::Transform::identity(),
-        None,
-    );
+        for x in 0..width as i32 {
+            let sx = x - dx;
+            if sx < 0 || sx >= width as i32 {
+                continue;
+            }
+
+            let a = alpha[(sy as u32 * width + sx as u32) as usize];
+            data[(y as u32 * width + x as u32) as usize] = shadow_colors[a as usize];
+        }
+    }
 
     pixmap.draw_pixmap(
         0,
@@ -637,6 +838,7 @@ fn apply_drop_shadow(
 
 fn apply_blur(
     fe: &usvg::filter::GaussianBlur,
+    ctx: &Context,
     cs: usvg::filter::ColorInterpolation,
     ts: usvg::Transform,
     input: Image,
@@ -649,13 +851,53 @@ fn apply_blur(
 
     let mut pixmap = input.into_color_space(cs)?.take()?;
 
-    if use_box_blur {
+    blur(ctx, std_dx, std_dy, use_box_blur, &mut pixmap);
+
+    Ok(Image::from_image(pixmap, cs))
+}
+
+fn blur(
+    ctx: &Context,
+    std_dx: f64,
+    std_dy: f64,
+    use_box_blur: bool,
+    pixmap: &mut tiny_skia::Pixmap,
+) {
+    if ctx.is_draft() {
+        box_blur::apply_single_pass(std_dx, std_dy, pixmap.as_image_ref_mut());
+    } else if use_multiscale_blur(ctx, std_dx, std_dy) {
+        multiscale_blur::apply(std_dx, std_dy, pixmap.as_image_ref_mut());
+    } else if use_box_blur {
         box_blur::apply(std_dx, std_dy, pixmap.as_image_ref_mut());
     } else {
         iir_blur::apply(std_dx, std_dy, pixmap.as_image_ref_mut());
     }
+}
 
-    Ok(Image::from_image(pixmap, cs))
+/// Same as [`blur`], but for an alpha mask.
+fn blur_alpha(
+    ctx: &Context,
+    std_dx: f64,
+    std_dy: f64,
+    use_box_blur: bool,
+    width: u32,
+    height: u32,
+    alpha: &mut [u8],
+) {
+    if ctx.is_draft() {
+        box_blur::apply_single_pass_alpha(std_dx, std_dy, width, height, alpha);
+    } else if use_multiscale_blur(ctx, std_dx, std_dy) {
+        multiscale_blur::apply_alpha(std_dx, std_dy, width, height, alpha);
+    } else if use_box_blur {
+        box_blur::apply_alpha(std_dx, std_dy, width, height, alpha);
+    } else {
+        iir_blur::apply_alpha(std_dx, std_dy, width, height, alpha);
+    }
+}
+
+/// Checks that a blur is large enough to be done at a reduced resolution.
+fn use_multiscale_blur(ctx: &Context, std_dx: f64, std_dy: f64) -> bool {
+    ctx.fast_filters && std_dx.max(std_dy) >= multiscale_blur::SIGMA_THRESHOLD
 }
 
 fn apply_offset(
@@ -789,7 +1031,7 @@ fn apply_merge(
     fe: &usvg::filter::Merge,
     cs: usvg::filter::ColorInterpolation,
     region: IntRect,
-    source: &tiny_skia::Pixmap,
+    source: &SourceImages,
     results: &[FilterResult],
 ) -> Result<Image, Error> {
     let mut pixmap = tiny_skia::Pixmap::try_create(region.width(), region.height())?;
@@ -853,6 +1095,7 @@ fn apply_tile(input: Image, region: IntRect) -> Result<Image, Error> {
 
 fn apply_image(
     fe: &usvg::filter::Image,
+    ctx: &Context,
     region: IntRect,
     subregion: IntRect,
     ts: usvg::Transform,
@@ -869,8 +1112,12 @@ fn apply_image(
         subregion.y() as f32,
     );
 
-    let ctx = crate::render::Context {
+    let ctx = Context {
         max_bbox: tiny_skia::IntRect::from_xywh(0, 0, region.width(), region.height()).unwrap(),
+        quality: ctx.quality,
+        fast_filters: ctx.fast_filters,
+        cache: ctx.cache,
+        approximate_images: ctx.approximate_images,
     };
 
     crate::render::render_nodes(fe.root(), &ctx, transform, &mut pixmap.as_mut());
@@ -9,65 +9,125 @@ use usvg::filter::MorphologyOperator;
 ///
 /// `src` pixels should have a **premultiplied alpha**.
 ///
+/// A rectangular min/max is separable, so it is done as a horizontal and a vertical pass.
+/// Each pass uses the van Herk/Gil-Werman algorithm, which takes a constant number
+/// of operations per pixel, no matter the radius.
+///
 /// # Allocations
 ///
-/// This method will allocate a copy of the `src` image as a back buffer.
+/// This method will allocate three line buffers.
 pub fn apply(operator: MorphologyOperator, rx: f32, ry: f32, src: ImageRefMut) {
     // No point in making matrix larger than image.
-    let columns = std::cmp::min(rx.ceil() as u32 * 2, src.width);
-    let rows = std::cmp::min(ry.ceil() as u32 * 2, src.height);
-    let target_x = (columns as f32 / 2.0).floor() as u32;
-    let target_y = (rows as f32 / 2.0).floor() as u32;
-
-    let width_max = src.width as i32 - 1;
-    let height_max = src.height as i32 - 1;
+    let columns = std::cmp::min(rx.ceil() as u32 * 2, src.width) as usize;
+    let rows = std::cmp::min(ry.ceil() as u32 * 2, src.height) as usize;
 
-    let mut buf = vec![RGBA8::default(); src.data.len()];
-    let mut buf = ImageRefMut::new(src.width, src.height, &mut buf);
-    let mut x = 0;
-    let mut y = 0;
-    for _ in src.data.iter() {
-        let mut new_p = RGBA8::default();
-        if operator == MorphologyOperator::Erode {
-            new_p.r = 255;
-            new_p.g = 255;
-            new_p.b = 255;
-            new_p.a = 255;
+    match operator {
+        MorphologyOperator::Erode => {
+            let white = RGBA8::new(255, 255, 255, 255);
+            apply_impl(columns, rows, white, erode, src);
+        }
+        MorphologyOperator::Dilate => {
+            apply_impl(columns, rows, RGBA8::default(), dilate, src);
         }
+    }
+}
+
+#[inline]
+fn erode(a: RGBA8, b: RGBA8) -> RGBA8 {
+    RGBA8::new(a.r.min(b.r), a.g.min(b.g), a.b.min(b.b), a.a.min(b.a))
+}
+
+#[inline]
+fn dilate(a: RGBA8, b: RGBA8) -> RGBA8 {
+    RGBA8::new(a.r.max(b.r), a.g.max(b.g), a.b.max(b.b), a.a.max(b.a))
+}
 
-        for oy in 0..rows {
-            for ox in 0..columns {
-                let tx = x as i32 - target_x as i32 + ox as i32;
-                let ty = y as i32 - target_y as i32 + oy as i32;
+fn apply_impl<F: Fn(RGBA8, RGBA8) -> RGBA8>(
+    columns: usize,
+    rows: usize,
+    identity: RGBA8,
+    op: F,
+    src: ImageRefMut,
+) {
+    let width = src.width as usize;
+    let height = src.height as usize;
 
-                if tx < 0 || tx > width_max || ty < 0 || ty > height_max {
-                    continue;
-                }
+    let max_len = std::cmp::max(width + columns, height + rows);
+    let mut line = Line {
+        padded: vec![identity; max_len],
+        forward: vec![identity; max_len],
+        backward: vec![identity; max_len],
+    };
+
+    if columns > 1 {
+        for row in src.data.chunks_exact_mut(width) {
+            line.apply(row.iter().copied(), columns, identity, &op);
+            row.copy_from_slice(&line.padded[..width]);
+        }
+    }
 
-                let p = src.pixel_at(tx as u32, ty as u32);
-                if operator == MorphologyOperator::Erode {
-                    new_p.r = std::cmp::min(p.r, new_p.r);
-                    new_p.g = std::cmp::min(p.g, new_p.g);
-                    new_p.b = std::cmp::min(p.b, new_p.b);
-                    new_p.a = std::cmp::min(p.a, new_p.a);
-                } else {
-                    new_p.r = std::cmp::max(p.r, new_p.r);
-                    new_p.g = std::cmp::max(p.g, new_p.g);
-                    new_p.b = std::cmp::max(p.b, new_p.b);
-                    new_p.a = std::cmp::max(p.a, new_p.a);
-                }
+    if rows > 1 {
+        for x in 0..width {
+            let column = src.data[x..].iter().step_by(width).copied();
+            line.apply(column, rows, identity, &op);
+            for (y, p) in line.padded[..height].iter().enumerate() {
+                src.data[y * width + x] = *p;
             }
         }
+    }
+}
+
+struct Line {
+    padded: Vec<RGBA8>,
+    forward: Vec<RGBA8>,
+    backward: Vec<RGBA8>,
+}
 
-        *buf.pixel_at_mut(x, y) = new_p;
+impl Line {
+    /// Applies `op` over a sliding window of `size` pixels to a line.
+    ///
+    /// The window of each pixel starts `size / 2` pixels before it.
+    /// Pixels outside the line are treated as `identity`.
+    ///
+    /// The result is stored at the start of `padded`.
+    fn apply<I, F>(&mut self, line: I, size: usize, identity: RGBA8, op: &F)
+    where
+        I: ExactSizeIterator<Item = RGBA8>,
+        F: Fn(RGBA8, RGBA8) -> RGBA8,
+    {
+        let len = line.len();
+        let offset = size / 2;
+        let padded_len = len + size - 1;
 
-        x += 1;
-        if x == src.width {
-            x = 0;
-            y += 1;
+        let padded = &mut self.padded[..padded_len];
+        padded.fill(identity);
+        for (p, c) in padded[offset..].iter_mut().zip(line) {
+            *p = c;
         }
-    }
 
-    // Do not use `mem::swap` because `data` referenced via FFI.
-    src.data.copy_from_slice(buf.data);
+        // Running results within blocks of `size` pixels, from the block start...
+        let forward = &mut self.forward[..padded_len];
+        for i in 0..padded_len {
+            forward[i] = if i % size == 0 {
+                padded[i]
+            } else {
+                op(forward[i - 1], padded[i])
+            };
+        }
+
+        // ...and from the block end.
+        let backward = &mut self.backward[..padded_len];
+        for i in (0..padded_len).rev() {
+            backward[i] = if i == padded_len - 1 || (i + 1) % size == 0 {
+                padded[i]
+            } else {
+                op(backward[i + 1], padded[i])
+            };
+        }
+
+        // Any window spans at most two blocks.
+        for x in 0..len {
+            padded[x] = op(backward[x], forward[x + size - 1]);
+        }
+    }
 }
@@ -1,8 +1,14 @@
 // Copyright 2018 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
+use std::sync::Arc;
+
+use crate::cache::{VectorKey, VectorTile};
+use crate::render::Context;
+
 pub fn render(
     image: &usvg::Image,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) {
@@ -10,22 +16,23 @@ pub fn render(
         return;
     }
 
-    render_inner(image.kind(), transform, image.rendering_mode(), pixmap);
+    render_inner(image.kind(), ctx, transform, image.rendering_mode(), pixmap);
 }
 
 pub fn render_inner(
     image_kind: &usvg::ImageKind,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     #[allow(unused_variables)] rendering_mode: usvg::ImageRendering,
     pixmap: &mut tiny_skia::PixmapMut,
 ) {
     match image_kind {
         usvg::ImageKind::SVG(ref tree) => {
-            render_vector(tree, transform, pixmap);
+            render_vector(tree, ctx, transform, pixmap);
         }
         #[cfg(feature = "raster-images")]
         _ => {
-            raster_images::render_raster(image_kind, transform, rendering_mode, pixmap);
+            raster_images::render_raster(image_kind, ctx, transform, rendering_mode, pixmap);
         }
         #[cfg(not(feature = "raster-images"))]
         _ => {
@@ -35,15 +42,61 @@ pub fn render_inner(
 }
 
 fn render_vector(
-    tree: &usvg::Tree,
+    tree: &Arc<usvg::Tree>,
+    ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) -> Option<()> {
-    let mut sub_pixmap = tiny_skia::Pixmap::new(pixmap.width(), pixmap.height()).unwrap();
-    crate::render(tree, transform, &mut sub_pixmap.as_mut());
+    if !tree.root().has_children() {
+        return None;
+    }
+
+    // Images outside the canvas must be neither rendered nor cached.
+    let canvas_rect = tiny_skia::IntRect::from_xywh(0, 0, pixmap.width(), pixmap.height())?;
+    let rect = crate::geom::fit_to_rect(layer_rect(tree, transform)?, canvas_rect)?;
+
+    if !transform.has_skew() {
+        // Without rotation and skew, an image can be rendered once per scale and subpixel offset
+        // and then simply copied to any integer position.
+        // This way, an image that is used many times would be rendered only once.
+        //
+        // Offsets change continuously between renders, like when panning.
+        // When allowed, snap them to a quarter of a pixel, so the same tiles would be reused.
+        let (tx, ty) = if ctx.approximate_images {
+            (
+                (transform.tx * 4.0).round() / 4.0,
+                (transform.ty * 4.0).round() / 4.0,
+            )
+        } else {
+            (transform.tx, transform.ty)
+        };
+        let x = tx.floor();
+        let y = ty.floor();
+        let tile_ts =
+            tiny_skia::Transform::from_row(transform.sx, 0.0, 0.0, transform.sy, tx - x, ty - y);
+
+        let canvas_area = pixmap.width() as u64 * pixmap.height() as u64;
+        if let Some(tile) = render_vector_tile(tree, ctx, tile_ts, canvas_area) {
+            pixmap.draw_pixmap(
+                x as i32 + tile.x,
+                y as i32 + tile.y,
+                tile.pixmap.as_ref().as_ref(),
+                &tiny_skia::PixmapPaint::default(),
+                tiny_skia::Transform::default(),
+                None,
+            );
+
+            return Some(());
+        }
+    }
+
+    // Otherwise, render only the visible part of an image.
+    let mut sub_pixmap = tiny_skia::Pixmap::new(rect.width(), rect.height())?;
+    let transform = transform.post_translate(-rect.x() as f32, -rect.y() as f32);
+    render_nested(tree, ctx, transform, &mut sub_pixmap);
     pixmap.draw_pixmap(
-        0,
-        0,
+        rect.x(),
+        rect.y(),
         sub_pixmap.as_ref(),
         &tiny_skia::PixmapPaint::default(),
         tiny_skia::Transform::default(),
@@ -53,8 +106,89 @@ fn render_vector(
     Some(())
 }
 
+/// Returns a cached rendered image, rendering it when needed.
+///
+/// Returns `None` when the image is larger than `max_area`, since most of it
+/// would likely be outside the canvas.
+fn render_vector_tile(
+    tree: &Arc<usvg::Tree>,
+    ctx: &Context,
+    transform: tiny_skia::Transform,
+    max_area: u64,
+) -> Option<VectorTile> {
+    let key = VectorKey::new(tree, transform, ctx.is_draft(), ctx.fast_filters);
+    if let Some(tile) = ctx.cache.vector_image(&key) {
+        return Some(tile);
+    }
+
+    let rect = layer_rect(tree, transform)?;
+    if rect.width() as u64 * rect.height() as u64 > max_area {
+        return None;
+    }
+
+    let mut pixmap = tiny_skia::Pixmap::new(rect.width(), rect.height())?;
+    let transform = transform.post_translate(-rect.x() as f32, -rect.y() as f32);
+    render_nested(tree, ctx, transform, &mut pixmap);
+
+    let tile = VectorTile {
+        pixmap: Arc::new(pixmap),
+        x: rect.x(),
+        y: rect.y(),
+    };
+    ctx.cache
+        .insert_vector_image(key, tree.clone(), tile.clone());
+    Some(tile)
+}
+
+/// Renders a nested image with the options of the parent one.
+fn render_nested(
+    tree: &usvg::Tree,
+    ctx: &Context,
+    transform: tiny_skia::Transform,
+    pixmap: &mut tiny_skia::Pixmap,
+) {
+    let ctx = Context {
+        max_bbox: crate::max_bbox(pixmap.size()),
+        quality: ctx.quality,
+        fast_filters: ctx.fast_filters,
+        cache: ctx.cache,
+        approximate_images: ctx.approximate_images,
+    };
+    crate::render::render_nodes(tree.root(), &ctx, transform, &mut pixmap.as_mut());
+}
+
+/// Returns an image layer bbox on the canvas, expanded by 2px for anti-aliasing.
+fn layer_rect(tree: &usvg::Tree, transform: tiny_skia::Transform) -> Option<tiny_skia::IntRect> {
+    let bbox = tree.root().abs_layer_bounding_box().transform(transform)?;
+    tiny_skia::IntRect::from_xywh(
+        bbox.x().floor() as i32 - 2,
+        bbox.y().floor() as i32 - 2,
+        bbox.width().ceil() as u32 + 4,
+        bbox.height().ceil() as u32 + 4,
+    )
+}
+
+/// Decodes all raster images of a tree into the cache.
+///
+/// Returns the number of images that failed to decode.
+pub fn decode_all(tree: &usvg::Tree, cache: &crate::Cache) -> usize {
+    #[cfg(feature = "raster-images")]
+    {
+        raster_images::decode_all(tree, cache)
+    }
+
+    #[cfg(not(feature = "raster-images"))]
+    {
+        let _ = (tree, cache);
+        0
+    }
+}
+
 #[cfg(feature = "raster-images")]
 mod raster_images {
+    use std::sync::Arc;
+
+    use crate::render::Context;
     use crate::OptionLog;
     use usvg::ImageRendering;
 
@@ -178,16 +312,13 @@ mod raster_images {
 
     pub(crate) fn render_raster(
         image: &usvg::ImageKind,
+        ctx: &Context,
         transform: tiny_skia::Transform,
         rendering_mode: usvg::ImageRendering,
         pixmap: &mut tiny_skia::PixmapMut,
     ) -> Option<()> {
-        let raster = decode_raster(image)?;
-
-        let rect = tiny_skia::Size::from_wh(raster.width() as f32, raster.height() as f32)?
-            .to_rect(0.0, 0.0)?;
-
         let quality = match rendering_mode {
+            _ if ctx.is_draft() => tiny_skia::FilterQuality::Nearest,
             ImageRendering::OptimizeQuality => tiny_skia::FilterQuality::Bicubic,
             ImageRendering::OptimizeSpeed => tiny_skia::FilterQuality::Nearest,
             ImageRendering::Smooth => tiny_skia::FilterQuality::Bilinear,
@@ -196,12 +327,36 @@ mod raster_images {
             ImageRendering::Pixelated => tiny_skia::FilterQuality::Nearest,
         };
 
+        let raster = get_raster(image, ctx, 0)?;
+
+        let rect = tiny_skia::Size::from_wh(raster.width() as f32, raster.height() as f32)?
+            .to_rect(0.0, 0.0)?;
+
+        // Heavy downscaling of a full size image is slow and aliased,
+        // so sample from a smaller mip level instead.
+        // Mip levels change the output slightly, so they have to be allowed explicitly.
+        // Nearest sampling is meant to preserve pixels, so it always uses the image itself.
+        let level = if ctx.approximate_images && quality != tiny_skia::FilterQuality::Nearest {
+            mip_level(&raster, transform)
+        } else {
+            0
+        };
+
+        let level_raster = if level != 0 {
+            get_raster(image, ctx, level).unwrap_or_else(|| raster.clone())
+        } else {
+            raster.clone()
+        };
+
         let pattern = tiny_skia::Pattern::new(
-            raster.as_ref(),
+            level_raster.as_ref().as_ref(),
             tiny_skia::SpreadMode::Pad,
             quality,
             1.0,
-            tiny_skia::Transform::default(),
+            tiny_skia::Transform::from_scale(
+                raster.width() as f32 / level_raster.width() as f32,
+                raster.height() as f32 / level_raster.height() as f32,
+            ),
         );
         let mut paint = tiny_skia::Paint::default();
         paint.shader = pattern;
@@ -210,4 +365,177 @@ mod raster_images {
 
         Some(())
     }
+
+    /// Returns a cached decoded image or its mip level, decoding or downscaling it when needed.
+    fn get_raster(
+        image: &usvg::ImageKind,
+        ctx: &Context,
+        level: u32,
+    ) -> Option<Arc<tiny_skia::Pixmap>> {
+        let data = match image {
+            usvg::ImageKind::JPEG(ref data)
+            | usvg::ImageKind::PNG(ref data)
+            | usvg::ImageKind::GIF(ref data)
+            | usvg::ImageKind::WEBP(ref data) => data,
+            usvg::ImageKind::SVG(_) => return None,
+        };
+
+        if let Some(pixmap) = ctx.cache.raster_image(data, level) {
+            return Some(pixmap);
+        }
+
+        let pixmap = if level == 0 {
+            decode_raster(image)?
+        } else {
+            downscale(&get_raster(image, ctx, level - 1)?)?
+        };
+
+        let pixmap = Arc::new(pixmap);
+        ctx.cache
+            .insert_raster_image(data.clone(), level, pixmap.clone(), true);
+        Some(pixmap)
+    }
+
+    pub(crate) fn decode_all(tree: &usvg::Tree, cache: &crate::Cache) -> usize {
+        use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+
+        let mut images = Vec::new();
+        let mut seen = std::collections::HashSet::new();
+        collect_rasters(tree.root(), &mut seen, &mut images);
+        if images.is_empty() {
+            return 0;
+        }
+
+        let threads = std::thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(1)
+            .min(images.len());
+
+        // Workers simply pull the next image until none left,
+        // which balances images of very different sizes better than fixed chunks.
+        let next = AtomicUsize::new(0);
+        let failed = AtomicUsize::new(0);
+        let is_full = AtomicBool::new(false);
+        let decode = || loop {
+            if is_full.load(Ordering::Relaxed) {
+                break;
+            }
+
+            let idx = next.fetch_add(1, Ordering::Relaxed);
+            let Some((data, kind)) = images.get(idx) else {
+                break;
+            };
+
+            if cache.raster_image(data, 0).is_some() {
+                continue;
+            }
+
+            match decode_raster(kind) {
+                Some(pixmap) => {
+                    // Do not evict images decoded earlier. Stop instead.
+                    if !cache.insert_raster_image(data.clone(), 0, Arc::new(pixmap), false) {
+                        is_full.store(true, Ordering::Relaxed);
+                    }
+                }
+                None => {
+                    failed.fetch_add(1, Ordering::Relaxed);
+                }
+            }
+        };
+
+        std::thread::scope(|s| {
+            for _ in 1..threads {
+                s.spawn(decode);
+            }
+
+            decode();
+        });
+
+        failed.into_inner()
+    }
+
+    /// Collects unique raster images of a group, including the ones
+    /// inside patterns, masks, clip paths, filters, text and nested SVG images.
+    fn collect_rasters(
+        parent: &usvg::Group,
+        seen: &mut std::collections::HashSet<usize>,
+        images: &mut Vec<(Arc<Vec<u8>>, usvg::ImageKind)>,
+    ) {
+        for node in parent.children() {
+            match node {
+                usvg::Node::Group(ref group) => collect_rasters(group, seen, images),
+                usvg::Node::Image(ref image) => match image.kind() {
+                    usvg::ImageKind::JPEG(ref data)
+                    | usvg::ImageKind::PNG(ref data)
+                    | usvg::ImageKind::GIF(ref data)
+                    | usvg::ImageKind::WEBP(ref data) => {
+                        if seen.insert(Arc::as_ptr(data) as usize) {
+                            images.push((data.clone(), image.kind().clone()));
+                        }
+                    }
+                    usvg::ImageKind::SVG(_) => {}
+                },
+                _ => {}
+            }
+
+            node.subroots(|subroot| collect_rasters(subroot, seen, images));
+        }
+    }
+
+    /// Selects a mip level for the current scale.
+    ///
+    /// A level is used only when it's still at least as large as the rendered image,
+    /// so the result would never be upscaled.
+    fn mip_level(raster: &tiny_skia::Pixmap, transform: tiny_skia::Transform) -> u32 {
+        let (sx, sy) = transform.get_scale();
+        let scale = sx.max(sy);
+        if !(scale > 0.0 && scale < 0.5) {
+            return 0;
+        }
+
+        let mut level = (1.0 / scale).log2().floor() as u32;
+
+        // Do not go below a single pixel.
+        let min_side = raster.width().min(raster.height());
+        while level > 0 && (min_side >> level) == 0 {
+            level -= 1;
+        }
+
+        level
+    }
+
+    /// Downscales an image by 2 using a box filter.
+    ///
+    /// Pixels should have a premultiplied alpha.
+    fn downscale(src: &tiny_skia::Pixmap) -> Option<tiny_skia::Pixmap> {
+        let src_w = src.width() as usize;
+        let src_h = src.height() as usize;
+        let w = (src_w + 1) / 2;
+        let h = (src_h + 1) / 2;
+        let mut dst = tiny_skia::Pixmap::new(w as u32, h as u32)?;
+
+        let src_data = src.data();
+        let dst_data = dst.data_mut();
+        for y in 0..h {
+            let y0 = y * 2;
+            let y1 = (y0 + 1).min(src_h - 1);
+            for x in 0..w {
+                let x0 = x * 2;
+                let x1 = (x0 + 1).min(src_w - 1);
+
+                let idx = |x: usize, y: usize| (y * src_w + x) * tiny_skia::BYTES_PER_PIXEL;
+                let (i00, i10, i01, i11) = (idx(x0, y0), idx(x1, y0), idx(x0, y1), idx(x1, y1));
+                let d = (y * w + x) * tiny_skia::BYTES_PER_PIXEL;
+                for c in 0..tiny_skia::BYTES_PER_PIXEL {
+                    let sum = src_data[i00 + c] as u32
+                        + src_data[i10 + c] as u32
+                        + src_data[i01 + c] as u32
+                        + src_data[i11 + c] as u32;
+                    dst_data[d + c] = ((sum + 2) / 4) as u8;
+                }
+            }
+        }
+
+        Some(dst)
+    }
 }
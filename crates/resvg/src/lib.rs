@@ -17,6 +17,9 @@
 pub use tiny_skia;
 pub use usvg;
 
+pub use cache::Cache;
+
+mod cache;
 mod clip;
 mod filter;
 mod geom;
@@ -25,6 +28,61 @@ mod mask;
 mod path;
 mod render;
 
+/// Rendering quality.
+#[derive(Clone, Copy, PartialEq, Eq, Default, Debug)]
+pub enum Quality {
+    /// Full quality rendering.
+    #[default]
+    Normal,
+    /// A fast, approximate rendering for previews and thumbnails.
+    ///
+    /// Disables anti-aliasing, approximates Gaussian blurs with a single box blur pass,
+    /// evaluates filters at half resolution and uses nearest-neighbor sampling
+    /// for raster images and patterns.
+    Draft,
+}
+
+/// Rendering options.
+#[derive(Clone, Copy, Default, Debug)]
+pub struct RenderOptions<'a> {
+    /// Rendering quality.
+    ///
+    /// Default: `Quality::Normal`
+    pub quality: Quality,
+
+    /// Allows approximating expensive filters.
+    ///
+    /// Gaussian blurs with a standard deviation of 16 pixels and above
+    /// are computed at a reduced resolution and upsampled back.
+    /// The difference from the full resolution blur stays within 8 levels per 8-bit channel,
+    /// while the cost drops with the square of the reduction factor.
+    ///
+    /// Has no effect in the draft quality, which approximates blurs anyway.
+    ///
+    /// Default: `false`
+    pub fast_filters: bool,
+
+    /// Allows approximating images.
+    ///
+    /// Heavily downscaled raster images are sampled from smaller mip levels,
+    /// and nested SVG images are snapped to a quarter of a pixel,
+    /// so their cached renders can be reused while panning.
+    /// The output can differ slightly from an exact render.
+    ///
+    /// Mostly useful together with a [`cache`](Self::cache) that outlives a single render.
+    ///
+    /// Default: `false`
+    pub approximate_images: bool,
+
+    /// A cache to reuse intermediate results between renders.
+    ///
+    /// When not set, a temporary cache is used for each render.
+    /// A cache never changes the output.
+    ///
+    /// Default: `None`
+    pub cache: Option<&'a Cache>,
+}
+
 /// Renders a tree onto the pixmap.
 ///
 /// `transform` will be used as a root transform.
@@ -35,18 +93,86 @@ pub fn render(
     tree: &usvg::Tree,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
+) {
+    render_with_options(tree, transform, &RenderOptions::default(), pixmap)
+}
+
+/// Renders a tree onto the pixmap using the specified options.
+///
+/// Same as [`render`], but allows trading quality for speed.
+pub fn render_with_options(
+    tree: &usvg::Tree,
+    transform: tiny_skia::Transform,
+    options: &RenderOptions,
+    pixmap: &mut tiny_skia::PixmapMut,
 ) {
     let target_size = tiny_skia::IntSize::from_wh(pixmap.width(), pixmap.height()).unwrap();
-    let max_bbox = tiny_skia::IntRect::from_xywh(
-        -(target_size.width() as i32) * 2,
-        -(target_size.height() as i32) * 2,
-        target_size.width() * 5,
-        target_size.height() * 5,
+    let max_bbox = max_bbox(target_size);
+
+    with_context(options, max_bbox, |ctx| {
+        render::render_nodes(tree.root(), ctx, transform, pixmap);
+    });
+}
+
+/// Renders a horizontal strip of a tree onto the pixmap.
+///
+/// Produces rows `y..y + pixmap.height()` of a [`render`] call onto a pixmap of `canvas_size`,
+/// but without allocating the whole canvas.
+/// Since the tree is shifted by `y` before rendering, float rounding can make
+/// anti-aliased edges differ from a full render by one 8-bit level.
+///
+/// Rendering an image strip by strip into a reusable buffer keeps the peak memory usage
+/// bounded by the strip size, which is useful for huge outputs.
+/// The only exception are groups with filters: a filter can read pixels outside the strip,
+/// so their layers still cover the whole filter region, limited by the canvas size.
+///
+/// `pixmap` must have the same width as `canvas_size`.
+///
+/// The produced content is in the sRGB color space.
+pub fn render_strip(
+    tree: &usvg::Tree,
+    transform: tiny_skia::Transform,
+    canvas_size: tiny_skia::IntSize,
+    y: u32,
+    pixmap: &mut tiny_skia::PixmapMut,
+) {
+    render_strip_with_options(
+        tree,
+        transform,
+        canvas_size,
+        y,
+        &RenderOptions::default(),
+        pixmap,
     )
-    .unwrap();
+}
 
-    let ctx = render::Context { max_bbox };
-    render::render_nodes(tree.root(), &ctx, transform, pixmap);
+/// Renders a horizontal strip of a tree onto the pixmap using the specified options.
+///
+/// Same as [`render_strip`], but allows trading quality for speed.
+/// Passing the same [`RenderOptions::cache`] for all strips of an image
+/// lets them share pattern tiles, nested images and decoded raster images.
+pub fn render_strip_with_options(
+    tree: &usvg::Tree,
+    transform: tiny_skia::Transform,
+    canvas_size: tiny_skia::IntSize,
+    y: u32,
+    options: &RenderOptions,
+    pixmap: &mut tiny_skia::PixmapMut,
+) {
+    debug_assert_eq!(canvas_size.width(), pixmap.width());
+
+    // The filter regions limit must be the one of the whole canvas,
+    // otherwise strips would produce different results.
+    let max_bbox = match max_bbox(canvas_size).translate(0, -(y as i32)) {
+        Some(v) => v,
+        None => return,
+    };
+
+    let transform = transform.post_translate(0.0, -(y as f32));
+
+    with_context(options, max_bbox, |ctx| {
+        render::render_nodes(tree.root(), ctx, transform, pixmap);
+    });
 }
 
 /// Renders a node onto the pixmap.
@@ -60,29 +186,76 @@ pub fn render(
 ///
 /// The produced content is in the sRGB color space.
 pub fn render_node(
+    node: &usvg::Node,
+    transform: tiny_skia::Transform,
+    pixmap: &mut tiny_skia::PixmapMut,
+) -> Option<()> {
+    render_node_with_options(node, transform, &RenderOptions::default(), pixmap)
+}
+
+/// Renders a node onto the pixmap using the specified options.
+///
+/// Same as [`render_node`], but allows trading quality for speed.
+pub fn render_node_with_options(
     node: &usvg::Node,
     mut transform: tiny_skia::Transform,
+    options: &RenderOptions,
     pixmap: &mut tiny_skia::PixmapMut,
 ) -> Option<()> {
     let bbox = node.abs_layer_bounding_box()?;
 
     let target_size = tiny_skia::IntSize::from_wh(pixmap.width(), pixmap.height()).unwrap();
-    let max_bbox = tiny_skia::IntRect::from_xywh(
-        -(target_size.width() as i32) * 2,
-        -(target_size.height() as i32) * 2,
-        target_size.width() * 5,
-        target_size.height() * 5,
-    )
-    .unwrap();
+    let max_bbox = max_bbox(target_size);
 
     transform = transform.pre_translate(-bbox.x(), -bbox.y());
 
-    let ctx = render::Context { max_bbox };
-    render::render_node(node, &ctx, transform, pixmap);
+    with_context(options, max_bbox, |ctx| {
+        render::render_node(node, ctx, transform, pixmap);
+    });
 
     Some(())
 }
 
+/// Creates a rendering context from the options and passes it to `f`.
+///
+/// When the options have no cache, a temporary one is used.
+fn with_context<F>(options: &RenderOptions, max_bbox: tiny_skia::IntRect, f: F)
+where
+    F: FnOnce(&render::Context),
+{
+    let tmp_cache;
+    let cache = match options.cache {
+        Some(cache) => cache,
+        None => {
+            tmp_cache = Cache::default();
+            &tmp_cache
+        }
+    };
+
+    let ctx = render::Context {
+        max_bbox,
+        quality: options.quality,
+        fast_filters: options.fast_filters,
+        cache,
+        approximate_images: options.approximate_images,
+    };
+    f(&ctx);
+}
+
+/// Returns the maximum area filter regions are allowed to occupy.
+///
+/// Filter regions and layers larger than 4x the canvas size would tank the performance,
+/// while not affecting the final result.
+pub(crate) fn max_bbox(size: tiny_skia::IntSize) -> tiny_skia::IntRect {
+    tiny_skia::IntRect::from_xywh(
+        -(size.width() as i32) * 2,
+        -(size.height() as i32) * 2,
+        size.width() * 5,
+        size.height() * 5,
+    )
+    .unwrap()
+}
+
 pub(crate) trait OptionLog {
     fn log_none<F: FnOnce()>(self, f: F) -> Self;
 }
@@ -47,6 +47,16 @@ fn process() -> Result<(), String> {
         }
     }
 
+    if let Some(ref list) = args.batch {
+        return process_batch(&args, list);
+    }
+
+    if let Some(ref from) = args.serve {
+        // Fonts are loaded upfront and shared by all requests.
+        load_fonts(&args.raw_args, args.usvg.fontdb_mut());
+        return process_serve(&args, from);
+    }
+
     let mut svg_data = timed(args.perf, "Reading", || -> Result<Vec<u8>, &str> {
         if let InputFrom::File(ref file) = args.in_svg {
             std::fs::read(file).map_err(|_| "failed to open the provided file")
@@ -99,10 +109,18 @@ fn process() -> Result<(), String> {
         return query_all(&tree);
     }
 
+    render_and_save(&args, &tree, args.out_png.as_ref().unwrap())
+}
+
+fn render_and_save(args: &Args, tree: &usvg::Tree, out_png: &OutputTo) -> Result<(), String> {
+    if let Some(strip_height) = args.strip_height {
+        return render_svg_strips(args, tree, strip_height, out_png);
+    }
+
     // Render.
-    let img = render_svg(&args, &tree)?;
+    let img = render_svg(args, tree)?;
 
-    match args.out_png.unwrap() {
+    match out_png {
         OutputTo::Stdout => {
             use std::io::Write;
             let buf = img.encode_png().map_err(|e| e.to_string())?;
@@ -118,6 +136,643 @@ fn process() -> Result<(), String> {
     Ok(())
 }
 
+/// A single batch mode job.
+struct BatchJob {
+    in_svg: path::PathBuf,
+    out_png: OutputTo,
+}
+
+fn process_batch(args: &Args, list: &InputFrom) -> Result<(), String> {
+    let jobs = parse_batch_list(list)?;
+    if jobs.is_empty() {
+        return Err("the batch list is empty".to_string());
+    }
+
+    // fontdb initialization is pretty expensive, so perform it only once
+    // and only when at least one of the files has text.
+    let shared_fontdb: std::sync::Mutex<Option<Arc<fontdb::Database>>> =
+        std::sync::Mutex::new(None);
+    let get_fontdb = || -> Arc<fontdb::Database> {
+        shared_fontdb
+            .lock()
+            .unwrap()
+            .get_or_insert_with(|| {
+                let mut fontdb = fontdb::Database::new();
+                load_fonts(&args.raw_args, &mut fontdb);
+                Arc::new(fontdb)
+            })
+            .clone()
+    };
+
+    let next_job = std::sync::atomic::AtomicUsize::new(0);
+    let failed = std::sync::atomic::AtomicUsize::new(0);
+    let workers = args.jobs.min(jobs.len());
+
+    std::thread::scope(|scope| {
+        for _ in 0..workers {
+            scope.spawn(|| loop {
+                let idx = next_job.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+                let job = match jobs.get(idx) {
+                    Some(v) => v,
+                    None => break,
+                };
+
+                if let Err(e) = process_batch_job(args, job, &get_fontdb) {
+                    eprintln!("Error: '{}': {}.", job.in_svg.display(), e);
+                    failed.fetch_add(1, std::sync::atomic::Ordering::Relaxed);
+                }
+            });
+        }
+    });
+
+    let failed = failed.into_inner();
+    if failed != 0 {
+        return Err(format!("{} of {} files failed", failed, jobs.len()));
+    }
+
+    Ok(())
+}
+
+fn process_batch_job(
+    args: &Args,
+    job: &BatchJob,
+    get_fontdb: &dyn Fn() -> Arc<fontdb::Database>,
+) -> Result<(), String> {
+    let mut svg_data =
+        std::fs::read(&job.in_svg).map_err(|_| "failed to open the provided file".to_string())?;
+
+    if svg_data.starts_with(&[0x1f, 0x8b]) {
+        svg_data = usvg::decompress_svgz(&svg_data).map_err(|e| e.to_string())?;
+    };
+
+    let svg_string = std::str::from_utf8(&svg_data)
+        .map_err(|_| "provided data has not an UTF-8 encoding".to_string())?;
+
+    let xml_opt = usvg::roxmltree::ParsingOptions {
+        allow_dtd: true,
+        ..Default::default()
+    };
+    let xml_tree = usvg::roxmltree::Document::parse_with_options(svg_string, xml_opt)
+        .map_err(|e| e.to_string())?;
+
+    let has_text_nodes = xml_tree
+        .descendants()
+        .any(|n| n.has_tag_name(("http://www.w3.org/2000/svg", "text")));
+
+    let mut opt = copy_usvg_options(&args.usvg);
+    if opt.resources_dir.is_none() {
+        opt.resources_dir = std::fs::canonicalize(&job.in_svg)
+            .ok()
+            .and_then(|p| p.parent().map(|p| p.to_path_buf()));
+    }
+    if has_text_nodes {
+        opt.fontdb = get_fontdb();
+    }
+
+    let tree = usvg::Tree::from_xmltree(&xml_tree, &opt).map_err(|e| e.to_string())?;
+
+    render_and_save(args, &tree, &job.out_png)
+}
+
+/// Copies parsing options.
+///
+/// `usvg::Options` is not `Clone`, because resolvers are boxed closures,
+/// so the copy gets the default resolvers.
+fn copy_usvg_options(opt: &usvg::Options<'static>) -> usvg::Options<'static> {
+    usvg::Options {
+        resources_dir: opt.resources_dir.clone(),
+        dpi: opt.dpi,
+        font_family: opt.font_family.clone(),
+        font_size: opt.font_size,
+        languages: opt.languages.clone(),
+        shape_rendering: opt.shape_rendering,
+        text_rendering: opt.text_rendering,
+        image_rendering: opt.image_rendering,
+        default_size: opt.default_size,
+        image_href_resolver: usvg::ImageHrefResolver::default(),
+        font_resolver: usvg::FontResolver::default(),
+        fontdb: opt.fontdb.clone(),
+        style_sheet: opt.style_sheet.clone(),
+        compiled_style_sheet: opt.compiled_style_sheet.clone(),
+        lazy_text: opt.lazy_text,
+        limits: opt.limits,
+    }
+}
+
+/// Parses a batch list.
+///
+/// Each line contains an input SVG and an output PNG path separated by a tab
+/// or, when there is no tab, by whitespace.
+/// Empty lines and lines starting with `#` are ignored.
+fn parse_batch_list(list: &InputFrom) -> Result<Vec<BatchJob>, String> {
+    let text = match list {
+        InputFrom::File(ref file) => {
+            std::fs::read_to_string(file).map_err(|_| "failed to read the batch list")?
+        }
+        InputFrom::Stdin => {
+            use std::io::Read;
+            let mut buf = String::new();
+            std::io::stdin()
+                .lock()
+                .read_to_string(&mut buf)
+                .map_err(|_| "failed to read stdin")?;
+            buf
+        }
+    };
+
+    let mut jobs = Vec::new();
+    for (i, line) in text.lines().enumerate() {
+        let line = line.trim();
+        if line.is_empty() || line.starts_with('#') {
+            continue;
+        }
+
+        let pair: Vec<&str> = if line.contains('\t') {
+            line.split('\t').map(|s| s.trim()).collect()
+        } else {
+            line.split_whitespace().collect()
+        };
+
+        match pair.as_slice() {
+            [in_svg, out_png] => jobs.push(BatchJob {
+                in_svg: path::PathBuf::from(in_svg),
+                out_png: OutputTo::File(path::PathBuf::from(out_png)),
+            }),
+            _ => {
+                return Err(format!(
+                    "batch list line {} must contain an input and an output path",
+                    i + 1
+                ))
+            }
+        }
+    }
+
+    Ok(jobs)
+}
+
+/// Creates an `xlink:href` string resolver that loads each external image only once.
+///
+/// Used in the server mode, so images referenced by many requests would share the same data
+/// and could be found in the render cache. An image is reloaded when its file was modified
+/// and dropped when the file is gone.
+fn shared_image_resolver() -> usvg::ImageHrefStringResolverFn<'static> {
+    let resolve = usvg::ImageHrefResolver::default_string_resolver();
+    let loaded = std::sync::Mutex::new(LoadedImages::default());
+    Box::new(move |href: &str, opts: &usvg::Options| {
+        let path = opts.get_abs_path(path::Path::new(href));
+        let modified = match std::fs::metadata(&path).and_then(|m| m.modified()) {
+            Ok(v) => v,
+            Err(_) => {
+                loaded.lock().unwrap().remove(&path);
+                return resolve(href, opts);
+            }
+        };
+
+        if let Some(kind) = loaded.lock().unwrap().get(&path, modified) {
+            return Some(kind);
+        }
+
+        let kind = resolve(href, opts);
+        match kind {
+            Some(ref kind) => loaded.lock().unwrap().insert(path, modified, kind.clone()),
+            None => loaded.lock().unwrap().remove(&path),
+        }
+
+        kind
+    })
+}
+
+/// External images kept by [`shared_image_resolver`], limited to `MAX_BYTES` of data.
+///
+/// The least recently used images are dropped first.
+#[derive(Default)]
+struct LoadedImages {
+    images: std::collections::HashMap<path::PathBuf, LoadedImage>,
+    bytes: usize,
+    tick: u64,
+}
+
+struct LoadedImage {
+    modified: std::time::SystemTime,
+    kind: usvg::ImageKind,
+    bytes: usize,
+    last_used: u64,
+}
+
+impl LoadedImages {
+    const MAX_BYTES: usize = 64 * 1024 * 1024;
+
+    fn get(
+        &mut self,
+        path: &path::Path,
+        modified: std::time::SystemTime,
+    ) -> Option<usvg::ImageKind> {
+        self.tick += 1;
+        let image = self.images.get_mut(path)?;
+        if image.modified != modified {
+            self.remove(path);
+            return None;
+        }
+
+        image.last_used = self.tick;
+        Some(image.kind.clone())
+    }
+
+    fn insert(
+        &mut self,
+        path: path::PathBuf,
+        modified: std::time::SystemTime,
+        kind: usvg::ImageKind,
+    ) {
+        self.remove(&path);
+
+        let bytes = match kind {
+            usvg::ImageKind::SVG(ref tree) => tree.memory_usage(),
+            usvg::ImageKind::JPEG(ref data)
+            | usvg::ImageKind::PNG(ref data)
+            | usvg::ImageKind::GIF(ref data)
+            | usvg::ImageKind::WEBP(ref data) => data.len(),
+        };
+        if bytes > Self::MAX_BYTES {
+            return;
+        }
+
+        while self.bytes + bytes > Self::MAX_BYTES {
+            let oldest = self
+                .images
+                .iter()
+                .min_by_key(|(_, image)| image.last_used)
+                .map(|(path, _)| path.clone());
+            match oldest {
+                Some(oldest) => self.remove(&oldest),
+                None => break,
+            }
+        }
+
+        self.tick += 1;
+        self.bytes += bytes;
+        self.images.insert(
+            path,
+            LoadedImage {
+                modified,
+                kind,
+                bytes,
+                last_used: self.tick,
+            },
+        );
+    }
+
+    fn remove(&mut self, path: &path::Path) {
+        if let Some(image) = self.images.remove(path) {
+            self.bytes -= image.bytes;
+        }
+    }
+}
+
+/// A render request received in the server mode.
+struct ServeRequest {
+    fit_to: FitTo,
+    background: Option<svgtypes::Color>,
+    export_id: Option<String>,
+    export_area_page: bool,
+    export_area_drawing: bool,
+    raw: bool,
+    svg: Vec<u8>,
+}
+
+/// Image size and PNG or raw RGBA data on success, an error message otherwise.
+type ServeResult = Result<(tiny_skia::IntSize, Vec<u8>), String>;
+
+struct ServeJob {
+    request: ServeRequest,
+    reply: std::sync::mpsc::Sender<ServeResult>,
+}
+
+fn process_serve(args: &Args, from: &ServeFrom) -> Result<(), String> {
+    let (job_tx, job_rx) = std::sync::mpsc::channel::<ServeJob>();
+    let job_rx = std::sync::Mutex::new(job_rx);
+
+    // Shared by all workers. Since external images are loaded only once in this mode,
+    // their decoded and rendered versions are reused between requests.
+    let cache = resvg::Cache::default();
+
+    std::thread::scope(|scope| {
+        for _ in 0..args.jobs {
+            scope.spawn(|| loop {
+                let job = match job_rx.lock().unwrap().recv() {
+                    Ok(v) => v,
+                    Err(_) => break,
+                };
+
+                // A panic must not take the worker down, otherwise the pool would shrink
+                // with each bad request.
+                let result = std::panic::catch_unwind(std::panic::AssertUnwindSafe(|| {
+                    serve_render(args, &cache, &job.request)
+                }))
+                .unwrap_or_else(|_| Err("rendering failed".to_string()));
+
+                // The client may be gone already.
+                let _ = job.reply.send(result);
+            });
+        }
+
+        let result = match *from {
+            ServeFrom::Stdio => {
+                serve_connection(scope, std::io::stdin().lock(), std::io::stdout(), &job_tx)
+            }
+            ServeFrom::Socket(ref path) => serve_socket(scope, path, &job_tx),
+        };
+
+        // Stop the workers.
+        drop(job_tx);
+
+        result
+    })
+}
+
+#[cfg(unix)]
+fn serve_socket<'scope>(
+    scope: &'scope std::thread::Scope<'scope, '_>,
+    path: &path::Path,
+    jobs: &std::sync::mpsc::Sender<ServeJob>,
+) -> Result<(), String> {
+    // A socket file left by a server that wasn't shut down cleanly would make `bind` fail.
+    // Remove it, unless another server is still listening on it.
+    if path.exists() && std::os::unix::net::UnixStream::connect(path).is_err() {
+        let is_socket = std::fs::symlink_metadata(path)
+            .map(|m| std::os::unix::fs::FileTypeExt::is_socket(&m.file_type()))
+            .unwrap_or(false);
+        if is_socket {
+            std::fs::remove_file(path)
+                .map_err(|e| format!("failed to remove '{}': {}", path.display(), e))?;
+        }
+    }
+
+    let listener = std::os::unix::net::UnixListener::bind(path)
+        .map_err(|e| format!("failed to bind '{}': {}", path.display(), e))?;
+
+    for stream in listener.incoming() {
+        let stream = match stream {
+            Ok(v) => v,
+            Err(e) => {
+                log::warn!("Failed to accept a connection cause {}.", e);
+                continue;
+            }
+        };
+
+        let jobs = jobs.clone();
+        scope.spawn(move || {
+            let writer = match stream.try_clone() {
+                Ok(v) => v,
+                Err(e) => {
+                    log::warn!("Failed to accept a connection cause {}.", e);
+                    return;
+                }
+            };
+
+            if let Err(e) = serve_connection(scope, stream, writer, &jobs) {
+                log::warn!("Connection closed cause {}.", e);
+            }
+        });
+    }
+
+    Ok(())
+}
+
+#[cfg(not(unix))]
+fn serve_socket<'scope>(
+    _: &'scope std::thread::Scope<'scope, '_>,
+    _: &path::Path,
+    _: &std::sync::mpsc::Sender<ServeJob>,
+) -> Result<(), String> {
+    Err("Unix sockets are not supported on this platform".to_string())
+}
+
+/// Reads requests from a client until EOF.
+///
+/// Requests are rendered concurrently, while responses are written
+/// in the same order as requests were received.
+fn serve_connection<'scope, R, W>(
+    scope: &'scope std::thread::Scope<'scope, '_>,
+    mut reader: R,
+    writer: W,
+    jobs: &std::sync::mpsc::Sender<ServeJob>,
+) -> Result<(), String>
+where
+    R: std::io::Read,
+    W: std::io::Write + Send + 'scope,
+{
+    let (order_tx, order_rx) = std::sync::mpsc::channel::<std::sync::mpsc::Receiver<ServeResult>>();
+
+    let writer_thread = scope.spawn(move || -> std::io::Result<()> {
+        use std::io::Write;
+
+        let mut writer = std::io::BufWriter::new(writer);
+        for reply in order_rx {
+            let result = reply
+                .recv()
+                .unwrap_or_else(|_| Err("rendering failed".to_string()));
+            write_serve_response(&mut writer, result)?;
+            writer.flush()?;
+        }
+
+        Ok(())
+    });
+
+    let mut result = Ok(());
+    loop {
+        let (options, svg) = match read_serve_request(&mut reader) {
+            Ok(Some(v)) => v,
+            Ok(None) => break,
+            Err(e) => {
+                result = Err(format!("failed to read a request cause {}", e));
+                break;
+            }
+        };
+
+        let (reply_tx, reply_rx) = std::sync::mpsc::channel();
+        match parse_serve_options(&options, svg) {
+            Ok(request) => {
+                let job = ServeJob {
+                    request,
+                    reply: reply_tx,
+                };
+
+                if jobs.send(job).is_err() {
+                    break;
+                }
+            }
+            Err(e) => {
+                let _ = reply_tx.send(Err(e));
+            }
+        }
+
+        if order_tx.send(reply_rx).is_err() {
+            // The writer has failed.
+            break;
+        }
+    }
+
+    drop(order_tx);
+
+    match writer_thread.join() {
+        Ok(Ok(())) => result,
+        Ok(Err(e)) => Err(format!("failed to write a response cause {}", e)),
+        Err(_) => Err("the writer thread has panicked".to_string()),
+    }
+}
+
+/// Reads a single request.
+///
+/// A request consists of a big-endian `u32` length followed by a UTF-8 options string
+/// and a big-endian `u32` length followed by SVG data.
+///
+/// Returns `None` on EOF.
+fn read_serve_request<R: std::io::Read>(
+    reader: &mut R,
+) -> std::io::Result<Option<(String, Vec<u8>)>> {
+    let options_len = match read_serve_u32(reader) {
+        Ok(v) => v,
+        Err(e) if e.kind() == std::io::ErrorKind::UnexpectedEof => return Ok(None),
+        Err(e) => return Err(e),
+    };
+    let options = read_serve_data(reader, options_len)?;
+    let options = String::from_utf8(options).map_err(|_| {
+        std::io::Error::new(
+            std::io::ErrorKind::InvalidData,
+            "options are not UTF-8 encoded",
+        )
+    })?;
+
+    let svg_len = read_serve_u32(reader)?;
+    let svg = read_serve_data(reader, svg_len)?;
+
+    Ok(Some((options, svg)))
+}
+
+fn read_serve_u32<R: std::io::Read>(reader: &mut R) -> std::io::Result<u32> {
+    let mut buf = [0; 4];
+    reader.read_exact(&mut buf)?;
+    Ok(u32::from_be_bytes(buf))
+}
+
+fn read_serve_data<R: std::io::Read>(reader: &mut R, len: u32) -> std::io::Result<Vec<u8>> {
+    use std::io::Read;
+
+    // Do not trust the length blindly and let the buffer grow as data arrives.
+    let mut buf = Vec::new();
+    reader.take(len as u64).read_to_end(&mut buf)?;
+    if buf.len() != len as usize {
+        return Err(std::io::ErrorKind::UnexpectedEof.into());
+    }
+
+    Ok(buf)
+}
+
+/// Writes a single response.
+///
+/// A response consists of a status byte (0 - success, 1 - error),
+/// big-endian `u32` image width and height (zeros on error)
+/// and a big-endian `u32` length followed by PNG data, raw RGBA data
+/// or an UTF-8 error message.
+fn write_serve_response<W: std::io::Write>(
+    writer: &mut W,
+    result: ServeResult,
+) -> std::io::Result<()> {
+    let (status, width, height, data) = match result {
+        Ok((size, data)) => (0u8, size.width(), size.height(), data),
+        Err(e) => (1u8, 0, 0, e.into_bytes()),
+    };
+
+    writer.write_all(&[status])?;
+    writer.write_all(&width.to_be_bytes())?;
+    writer.write_all(&height.to_be_bytes())?;
+    writer.write_all(&(data.len() as u32).to_be_bytes())?;
+    writer.write_all(&data)
+}
+
+/// Parses request options.
+///
+/// Options are whitespace-separated `key=value` pairs and flags, matching the CLI ones:
+/// `width=`, `height=`, `zoom=`, `background=`, `export-id=`, `export-area-page`,
+/// `export-area-drawing` and `format=png|rgba`.
+fn parse_serve_options(text: &str, svg: Vec<u8>) -> Result<ServeRequest, String> {
+    let mut request = ServeRequest {
+        fit_to: FitTo::Original,
+        background: None,
+        export_id: None,
+        export_area_page: false,
+        export_area_drawing: false,
+        raw: false,
+        svg,
+    };
+
+    let mut width = None;
+    let mut height = None;
+    let mut zoom = None;
+    for item in text.split_whitespace() {
+        let (key, value) = match item.split_once('=') {
+            Some((key, value)) => (key, Some(value)),
+            None => (item, None),
+        };
+
+        match (key, value) {
+            ("width", Some(v)) => width = Some(parse_length(v)?),
+            ("height", Some(v)) => height = Some(parse_length(v)?),
+            ("zoom", Some(v)) => zoom = Some(parse_zoom(v)?),
+            ("background", Some(v)) => {
+                request.background = Some(v.parse().map_err(|_| "invalid background")?)
+            }
+            ("export-id", Some(v)) => request.export_id = Some(v.to_string()),
+            ("export-area-page", None) => request.export_area_page = true,
+            ("export-area-drawing", None) => request.export_area_drawing = true,
+            ("format", Some("png")) => request.raw = false,
+            ("format", Some("rgba")) => request.raw = true,
+            _ => return Err(format!("invalid option '{}'", item)),
+        }
+    }
+
+    request.fit_to = match (width, height, zoom) {
+        (Some(w), Some(h), _) => FitTo::Size(w, h),
+        (Some(w), None, _) => FitTo::Width(w),
+        (None, Some(h), _) => FitTo::Height(h),
+        (None, None, Some(z)) => FitTo::Zoom(z),
+        (None, None, None) => FitTo::Original,
+    };
+
+    Ok(request)
+}
+
+fn serve_render(args: &Args, cache: &resvg::Cache, request: &ServeRequest) -> ServeResult {
+    let tree = usvg::Tree::from_data(&request.svg, &args.usvg).map_err(|e| e.to_string())?;
+
+    let options = resvg::RenderOptions {
+        fast_filters: args.fast_filters,
+        cache: Some(cache),
+        ..resvg::RenderOptions::default()
+    };
+
+    let img = render_image(
+        &tree,
+        &options,
+        request.fit_to,
+        request.background,
+        request.export_id.as_deref(),
+        request.export_area_page,
+        request.export_area_drawing,
+    )?;
+
+    // Unwrap is safe, because pixmap size is always valid.
+    let size = tiny_skia::IntSize::from_wh(img.width(), img.height()).unwrap();
+    let data = if request.raw {
+        img.take()
+    } else {
+        img.encode_png().map_err(|e| e.to_string())?
+    };
+
+    Ok((size, data))
+}
+
 const HELP: &str = "\
 resvg is an SVG rendering application.
 
@@ -126,6 +781,8 @@ USAGE:
   resvg [OPTIONS] <in-svg> -c         # from file to stdout
   resvg [OPTIONS] - <out-png>         # from stdin to file
   resvg [OPTIONS] - -c                # from stdin to stdout
+  resvg [OPTIONS] --batch <list>      # from files to files
+  resvg [OPTIONS] --serve             # from requests to responses
 
   resvg in.svg out.png
   resvg -z 4 in.svg out.png
@@ -206,6 +863,36 @@ OPTIONS:
   --export-area-drawing         Use drawing's tight bounding box instead of image size.
                                 Used during normal rendering and not during --export-id
 
+  --fast-filters                Computes large blurs at a reduced resolution.
+                                Much faster, but can differ from the exact result
+                                by up to 8 color levels
+
+  --strip-height ROWS           Renders the image in strips of the specified height
+                                and streams them directly into the output PNG.
+                                Reduces memory usage for huge images.
+                                Has no effect with --export-id and --export-area-drawing
+
+  --batch PATH                  Renders all files listed in the specified file.
+                                Each line should contain an input SVG and an output PNG
+                                path separated by a tab or a space.
+                                Use '-' to read the list from stdin.
+                                Fonts are loaded only once. Failed files are reported
+                                and do not abort the batch
+  --serve                       Runs a render server reading requests from stdin
+                                and writing responses to stdout.
+                                A request is an options string and SVG data,
+                                each prefixed with a big-endian u32 length.
+                                Options are space-separated: width=N height=N zoom=N
+                                background=COLOR export-id=ID export-area-page
+                                export-area-drawing format=png|rgba
+                                A response is a status byte (0 - ok, 1 - error),
+                                u32 width, u32 height and length-prefixed PNG,
+                                premultiplied RGBA or error message data.
+                                Responses are sent in the order of requests
+  --serve-socket PATH           Runs a render server on the specified Unix socket
+  -j, --jobs NUM                Sets the number of worker threads in the batch
+                                and server modes [default: number of CPUs]
+
   --perf                        Prints performance stats
   --quiet                       Disables warnings
 
@@ -247,6 +934,15 @@ struct CliArgs {
 
     export_area_drawing: bool,
 
+    fast_filters: bool,
+
+    strip_height: Option<u32>,
+
+    batch: Option<String>,
+    serve: bool,
+    serve_socket: Option<path::PathBuf>,
+    jobs: Option<usize>,
+
     perf: bool,
     quiet: bool,
 
@@ -309,8 +1005,17 @@ fn collect_args() -> Result<CliArgs, pico_args::Error> {
         export_area_page: input.contains("--export-area-page"),
 
         export_area_drawing: input.contains("--export-area-drawing"),
+
+        fast_filters: input.contains("--fast-filters"),
         style_sheet: input.opt_value_from_str("--stylesheet").unwrap_or_default(),
 
+        strip_height: input.opt_value_from_fn("--strip-height", parse_length)?,
+
+        batch: input.opt_value_from_str("--batch")?,
+        serve: input.contains("--serve"),
+        serve_socket: input.opt_value_from_str("--serve-socket")?,
+        jobs: input.opt_value_from_fn(["-j", "--jobs"], parse_jobs)?,
+
         perf: input.contains("--perf"),
         quiet: input.contains("--quiet"),
 
@@ -349,6 +1054,16 @@ fn parse_zoom(s: &str) -> Result<f32, String> {
     }
 }
 
+fn parse_jobs(s: &str) -> Result<usize, String> {
+    let n: usize = s.parse().map_err(|_| "invalid number")?;
+
+    if n > 0 {
+        Ok(n)
+    } else {
+        Err("jobs number cannot be zero".to_string())
+    }
+}
+
 fn parse_font_size(s: &str) -> Result<u32, String> {
     let n: u32 = s.parse().map_err(|_| "invalid number")?;
 
@@ -384,6 +1099,12 @@ enum OutputTo {
     File(path::PathBuf),
 }
 
+#[derive(Clone, PartialEq, Debug)]
+enum ServeFrom {
+    Stdio,
+    Socket(path::PathBuf),
+}
+
 #[derive(Clone, Copy, PartialEq, Debug)]
 enum FitTo {
     /// Keep original size.
@@ -461,6 +1182,11 @@ struct Args {
     export_id: Option<String>,
     export_area_page: bool,
     export_area_drawing: bool,
+    fast_filters: bool,
+    strip_height: Option<u32>,
+    batch: Option<InputFrom>,
+    serve: Option<ServeFrom>,
+    jobs: usize,
     perf: bool,
     quiet: bool,
     usvg: usvg::Options<'static>,
@@ -477,7 +1203,40 @@ fn parse_args() -> Result<Args, String> {
         std::process::exit(0);
     }
 
-    let (in_svg, out_png) = {
+    let batch = args.batch.as_ref().map(|list| {
+        if list == "-" {
+            InputFrom::Stdin
+        } else {
+            InputFrom::File(list.into())
+        }
+    });
+
+    let serve = match args.serve_socket {
+        Some(ref path) => Some(ServeFrom::Socket(path.clone())),
+        None if args.serve => Some(ServeFrom::Stdio),
+        None => None,
+    };
+
+    if batch.is_some() && serve.is_some() {
+        return Err("--batch and --serve cannot be used together".to_string());
+    }
+
+    if batch.is_some() || serve.is_some() {
+        if args.query_all {
+            return Err("--query-all cannot be used with --batch and --serve".to_string());
+        }
+
+        if args.input.is_some() {
+            return Err(
+                "<in-svg> and <out-png> cannot be used with --batch and --serve".to_string(),
+            );
+        }
+    }
+
+    let (in_svg, out_png) = if batch.is_some() || serve.is_some() {
+        // Inputs and outputs are defined by the batch list or requests.
+        (InputFrom::Stdin, None)
+    } else {
         let in_svg = match args.input {
             Some(ref v) => v,
             None => return Err("input file is missing".to_string()),
@@ -504,11 +1263,15 @@ fn parse_args() -> Result<Args, String> {
         (svg_from, out_png)
     };
 
-    if !args.query_all && out_png.is_none() {
+    if !args.query_all && batch.is_none() && serve.is_none() && out_png.is_none() {
         return Err("<out-png> must be set".to_string());
     }
 
-    if in_svg == InputFrom::Stdin && args.resources_dir.is_none() {
+    if in_svg == InputFrom::Stdin
+        && batch.is_none()
+        && serve.is_none()
+        && args.resources_dir.is_none()
+    {
         eprintln!("Warning: Make sure to set --resources-dir when reading SVG from stdin.");
     }
 
@@ -520,6 +1283,14 @@ fn parse_args() -> Result<Args, String> {
         eprintln!("Warning: --export-area-drawing has no effect when --export-id is set.");
     }
 
+    let mut strip_height = args.strip_height;
+    if strip_height.is_some() && (args.export_id.is_some() || args.export_area_drawing) {
+        eprintln!(
+            "Warning: --strip-height has no effect with --export-id and --export-area-drawing."
+        );
+        strip_height = None;
+    }
+
     let export_id = args.export_id.as_ref().map(|v| v.to_string());
 
     let mut fit_to = FitTo::Original;
@@ -540,6 +1311,7 @@ fn parse_args() -> Result<Args, String> {
     let resources_dir = match args.resources_dir {
         Some(ref v) => Some(v.clone()),
         None => {
+            // In the batch mode, resolved per file.
             if let InputFrom::File(ref input) = in_svg {
                 // Get input file absolute directory.
                 std::fs::canonicalize(input)
@@ -551,11 +1323,16 @@ fn parse_args() -> Result<Args, String> {
         }
     };
 
+    // Parse the stylesheet once, since it can be used for many files in batch and server modes.
     let style_sheet = match args.style_sheet.as_ref() {
         Some(p) => Some(
             std::fs::read(p)
                 .ok()
-                .and_then(|s| std::str::from_utf8(&s).ok().map(|s| s.to_string()))
+                .and_then(|s| {
+                    std::str::from_utf8(&s)
+                        .ok()
+                        .map(|s| Arc::new(usvg::CompiledStyleSheet::parse(s)))
+                })
                 .ok_or("failed to read stylesheet".to_string())?,
         ),
         None => None,
@@ -574,10 +1351,16 @@ fn parse_args() -> Result<Args, String> {
         text_rendering: args.text_rendering,
         image_rendering: args.image_rendering,
         default_size,
-        image_href_resolver: usvg::ImageHrefResolver::default(),
-        font_resolver: usvg::FontResolver::default(),
-        fontdb: Arc::new(fontdb::Database::new()),
-        style_sheet,
+        image_href_resolver: usvg::ImageHrefResolver {
+            resolve_string: if serve.is_some() {
+                shared_image_resolver()
+            } else {
+                usvg::ImageHrefResolver::default_string_resolver()
+            },
+            ..usvg::ImageHrefResolver::default()
+        },
+        compiled_style_sheet: style_sheet,
+        ..usvg::Options::default()
     };
 
     Ok(Args {
@@ -587,6 +1370,15 @@ fn parse_args() -> Result<Args, String> {
         export_id,
         export_area_page: args.export_area_page,
         export_area_drawing: args.export_area_drawing,
+        fast_filters: args.fast_filters,
+        strip_height,
+        batch,
+        serve,
+        jobs: args.jobs.unwrap_or_else(|| {
+            std::thread::available_parallelism()
+                .map(|n| n.get())
+                .unwrap_or(1)
+        }),
         perf: args.perf,
         quiet: args.quiet,
         usvg,
@@ -669,7 +1461,39 @@ fn query_all_impl(parent: &usvg::Group) -> usize {
 fn render_svg(args: &Args, tree: &usvg::Tree) -> Result<tiny_skia::Pixmap, String> {
     let now = std::time::Instant::now();
 
-    let img = if let Some(ref id) = args.export_id {
+    let options = resvg::RenderOptions {
+        fast_filters: args.fast_filters,
+        ..resvg::RenderOptions::default()
+    };
+
+    let img = render_image(
+        tree,
+        &options,
+        args.fit_to,
+        args.background,
+        args.export_id.as_deref(),
+        args.export_area_page,
+        args.export_area_drawing,
+    )?;
+
+    if args.perf {
+        let elapsed = now.elapsed().as_micros() as f64 / 1000.0;
+        println!("Rendering: {:.2}ms", elapsed);
+    }
+
+    Ok(img)
+}
+
+fn render_image(
+    tree: &usvg::Tree,
+    options: &resvg::RenderOptions,
+    fit_to: FitTo,
+    background: Option<svgtypes::Color>,
+    export_id: Option<&str>,
+    export_area_page: bool,
+    export_area_drawing: bool,
+) -> Result<tiny_skia::Pixmap, String> {
+    let img = if let Some(id) = export_id {
         let node = match tree.node_by_id(id) {
             Some(node) => node,
             None => return Err(format!("SVG doesn't have '{}' ID", id)),
@@ -679,36 +1503,34 @@ fn render_svg(args: &Args, tree: &usvg::Tree) -> Result<tiny_skia::Pixmap, Strin
             .abs_layer_bounding_box()
             .ok_or_else(|| "node has zero size".to_string())?;
 
-        let size = args
-            .fit_to
+        let size = fit_to
             .fit_to_size(bbox.size().to_int_size())
             .ok_or_else(|| "target size is zero".to_string())?;
 
         // Unwrap is safe, because `size` is already valid.
         let mut pixmap = tiny_skia::Pixmap::new(size.width(), size.height()).unwrap();
 
-        if !args.export_area_page {
-            if let Some(background) = args.background {
+        if !export_area_page {
+            if let Some(background) = background {
                 pixmap.fill(svg_to_skia_color(background));
             }
         }
 
-        let ts = args.fit_to.fit_to_transform(tree.size().to_int_size());
+        let ts = fit_to.fit_to_transform(tree.size().to_int_size());
 
-        resvg::render_node(node, ts, &mut pixmap.as_mut());
+        resvg::render_node_with_options(node, ts, options, &mut pixmap.as_mut());
 
-        if args.export_area_page {
+        if export_area_page {
             // TODO: add offset support to render_node() so we would not need an additional pixmap
 
-            let size = args
-                .fit_to
+            let size = fit_to
                 .fit_to_size(tree.size().to_int_size())
                 .ok_or_else(|| "target size is zero".to_string())?;
 
             // Unwrap is safe, because `size` is already valid.
             let mut page_pixmap = tiny_skia::Pixmap::new(size.width(), size.height()).unwrap();
 
-            if let Some(background) = args.background {
+            if let Some(background) = background {
                 page_pixmap.fill(svg_to_skia_color(background));
             }
 
@@ -725,35 +1547,115 @@ fn render_svg(args: &Args, tree: &usvg::Tree) -> Result<tiny_skia::Pixmap, Strin
             pixmap
         }
     } else {
-        let size = args
-            .fit_to
+        let size = fit_to
             .fit_to_size(tree.size().to_int_size())
             .ok_or_else(|| "target size is zero".to_string())?;
 
         // Unwrap is safe, because `size` is already valid.
         let mut pixmap = tiny_skia::Pixmap::new(size.width(), size.height()).unwrap();
 
-        if let Some(background) = args.background {
+        if let Some(background) = background {
             pixmap.fill(svg_to_skia_color(background));
         }
 
-        let ts = args.fit_to.fit_to_transform(tree.size().to_int_size());
+        let ts = fit_to.fit_to_transform(tree.size().to_int_size());
 
-        resvg::render(tree, ts, &mut pixmap.as_mut());
+        resvg::render_with_options(tree, ts, options, &mut pixmap.as_mut());
 
-        if args.export_area_drawing {
+        if export_area_drawing {
             trim_pixmap(tree, ts, &pixmap).unwrap_or(pixmap)
         } else {
             pixmap
         }
     };
 
+    Ok(img)
+}
+
+fn render_svg_strips(
+    args: &Args,
+    tree: &usvg::Tree,
+    strip_height: u32,
+    out_png: &OutputTo,
+) -> Result<(), String> {
+    let now = std::time::Instant::now();
+
+    let size = args
+        .fit_to
+        .fit_to_size(tree.size().to_int_size())
+        .ok_or_else(|| "target size is zero".to_string())?;
+
+    let ts = args.fit_to.fit_to_transform(tree.size().to_int_size());
+
+    let output: Box<dyn std::io::Write> = match out_png {
+        OutputTo::File(ref file) => {
+            let file =
+                std::fs::File::create(file).map_err(|_| "failed to create the output file")?;
+            Box::new(std::io::BufWriter::new(file))
+        }
+        OutputTo::Stdout => Box::new(std::io::stdout()),
+    };
+
+    let mut encoder = png::Encoder::new(output, size.width(), size.height());
+    encoder.set_color(png::ColorType::Rgba);
+    encoder.set_depth(png::BitDepth::Eight);
+    let mut writer = encoder
+        .write_header()
+        .and_then(|w| w.into_stream_writer())
+        .map_err(|e| e.to_string())?;
+
+    let strip_height = strip_height.min(size.height());
+    let mut strip = tiny_skia::Pixmap::new(size.width(), strip_height)
+        .ok_or_else(|| "failed to allocate a strip".to_string())?;
+    let background = args
+        .background
+        .map(svg_to_skia_color)
+        .unwrap_or(tiny_skia::Color::TRANSPARENT);
+
+    // Shared by all strips, so images and pattern tiles are decoded and rendered only once.
+    let cache = resvg::Cache::default();
+    let options = resvg::RenderOptions {
+        fast_filters: args.fast_filters,
+        cache: Some(&cache),
+        ..resvg::RenderOptions::default()
+    };
+
+    let mut row = vec![0; size.width() as usize * tiny_skia::BYTES_PER_PIXEL];
+    let mut y = 0;
+    while y < size.height() {
+        let rows = strip_height.min(size.height() - y);
+
+        strip.fill(background);
+        resvg::render_strip_with_options(tree, ts, size, y, &options, &mut strip.as_mut());
+
+        // PNG stores demultiplied colors.
+        for pixels in strip
+            .pixels()
+            .chunks(size.width() as usize)
+            .take(rows as usize)
+        {
+            for (p, out) in pixels
+                .iter()
+                .zip(row.chunks_mut(tiny_skia::BYTES_PER_PIXEL))
+            {
+                let c = p.demultiply();
+                out.copy_from_slice(&[c.red(), c.green(), c.blue(), c.alpha()]);
+            }
+
+            std::io::Write::write_all(&mut writer, &row).map_err(|e| e.to_string())?;
+        }
+
+        y += rows;
+    }
+
+    writer.finish().map_err(|e| e.to_string())?;
+
     if args.perf {
         let elapsed = now.elapsed().as_micros() as f64 / 1000.0;
-        println!("Rendering: {:.2}ms", elapsed);
+        println!("Rendering and saving: {:.2}ms", elapsed);
     }
 
-    Ok(img)
+    Ok(())
 }
 
 fn trim_pixmap(
@@ -1,11 +1,18 @@
 // Copyright 2019 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
+use std::sync::Arc;
+
+use crate::cache::{PatternKey, PatternTile};
 use crate::render::Context;
 
+/// Renders a path.
+///
+/// `opacity` is applied to the fill and stroke paint on top of their own opacity.
 pub fn render(
     path: &usvg::Path,
     blend_mode: tiny_skia::BlendMode,
+    opacity: usvg::Opacity,
     ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
@@ -15,17 +22,18 @@ pub fn render(
     }
 
     if path.paint_order() == usvg::PaintOrder::FillAndStroke {
-        fill_path(path, blend_mode, ctx, transform, pixmap);
-        stroke_path(path, blend_mode, ctx, transform, pixmap);
+        fill_path(path, blend_mode, opacity, ctx, transform, pixmap);
+        stroke_path(path, blend_mode, opacity, ctx, transform, pixmap);
     } else {
-        stroke_path(path, blend_mode, ctx, transform, pixmap);
-        fill_path(path, blend_mode, ctx, transform, pixmap);
+        stroke_path(path, blend_mode, opacity, ctx, transform, pixmap);
+        fill_path(path, blend_mode, opacity, ctx, transform, pixmap);
     }
 }
 
 pub fn fill_path(
     path: &usvg::Path,
     blend_mode: tiny_skia::BlendMode,
+    opacity: usvg::Opacity,
     ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
@@ -42,32 +50,33 @@ pub fn fill_path(
         usvg::FillRule::EvenOdd => tiny_skia::FillRule::EvenOdd,
     };
 
+    let opacity = fill.opacity() * opacity;
     let pattern_pixmap;
     let mut paint = tiny_skia::Paint::default();
     match fill.paint() {
         usvg::Paint::Color(c) => {
-            paint.set_color_rgba8(c.red, c.green, c.blue, fill.opacity().to_u8());
+            paint.set_color_rgba8(c.red, c.green, c.blue, opacity.to_u8());
         }
         usvg::Paint::LinearGradient(ref lg) => {
-            paint.shader = convert_linear_gradient(lg, fill.opacity())?;
+            paint.shader = convert_linear_gradient(lg, opacity)?;
         }
         usvg::Paint::RadialGradient(ref rg) => {
-            paint.shader = convert_radial_gradient(rg, fill.opacity())?;
+            paint.shader = convert_radial_gradient(rg, opacity)?;
         }
         usvg::Paint::Pattern(ref pattern) => {
             let (patt_pix, patt_ts) = render_pattern_pixmap(pattern, ctx, transform)?;
 
             pattern_pixmap = patt_pix;
             paint.shader = tiny_skia::Pattern::new(
-                pattern_pixmap.as_ref(),
+                pattern_pixmap.as_ref().as_ref(),
                 tiny_skia::SpreadMode::Repeat,
-                tiny_skia::FilterQuality::Bicubic,
-                fill.opacity().get(),
+                pattern_quality(ctx),
+                opacity.get(),
                 patt_ts,
             );
         }
     }
-    paint.anti_alias = path.rendering_mode().use_shape_antialiasing();
+    paint.anti_alias = path.rendering_mode().use_shape_antialiasing() && !ctx.is_draft();
     paint.blend_mode = blend_mode;
 
     pixmap.fill_path(path.data(), &paint, rule, transform, None);
@@ -77,37 +86,39 @@ pub fn fill_path(
 fn stroke_path(
     path: &usvg::Path,
     blend_mode: tiny_skia::BlendMode,
+    opacity: usvg::Opacity,
     ctx: &Context,
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) -> Option<()> {
     let stroke = path.stroke()?;
+    let opacity = stroke.opacity() * opacity;
     let pattern_pixmap;
     let mut paint = tiny_skia::Paint::default();
     match stroke.paint() {
         usvg::Paint::Color(c) => {
-            paint.set_color_rgba8(c.red, c.green, c.blue, stroke.opacity().to_u8());
+            paint.set_color_rgba8(c.red, c.green, c.blue, opacity.to_u8());
         }
         usvg::Paint::LinearGradient(ref lg) => {
-            paint.shader = convert_linear_gradient(lg, stroke.opacity())?;
+            paint.shader = convert_linear_gradient(lg, opacity)?;
         }
         usvg::Paint::RadialGradient(ref rg) => {
-            paint.shader = convert_radial_gradient(rg, stroke.opacity())?;
+            paint.shader = convert_radial_gradient(rg, opacity)?;
         }
         usvg::Paint::Pattern(ref pattern) => {
             let (patt_pix, patt_ts) = render_pattern_pixmap(pattern, ctx, transform)?;
 
             pattern_pixmap = patt_pix;
             paint.shader = tiny_skia::Pattern::new(
-                pattern_pixmap.as_ref(),
+                pattern_pixmap.as_ref().as_ref(),
                 tiny_skia::SpreadMode::Repeat,
-                tiny_skia::FilterQuality::Bicubic,
-                stroke.opacity().get(),
+                pattern_quality(ctx),
+                opacity.get(),
                 patt_ts,
             );
         }
     }
-    paint.anti_alias = path.rendering_mode().use_shape_antialiasing();
+    paint.anti_alias = path.rendering_mode().use_shape_antialiasing() && !ctx.is_draft();
     paint.blend_mode = blend_mode;
 
     pixmap.stroke_path(path.data(), &paint, &stroke.to_tiny_skia(), transform, None);
@@ -175,16 +186,52 @@ fn convert_base_gradient(
     Some((mode, points))
 }
 
+fn pattern_quality(ctx: &Context) -> tiny_skia::FilterQuality {
+    if ctx.is_draft() {
+        tiny_skia::FilterQuality::Nearest
+    } else {
+        tiny_skia::FilterQuality::Bicubic
+    }
+}
+
 fn render_pattern_pixmap(
-    pattern: &usvg::Pattern,
+    pattern: &Arc<usvg::Pattern>,
     ctx: &Context,
     transform: tiny_skia::Transform,
-) -> Option<(tiny_skia::Pixmap, tiny_skia::Transform)> {
+) -> Option<(Arc<tiny_skia::Pixmap>, tiny_skia::Transform)> {
     let (sx, sy) = {
         let ts2 = transform.pre_concat(pattern.transform());
         ts2.get_scale()
     };
 
+    // The same pattern is usually used by many paths at the same scale,
+    // so there is no need to render the same tile over and over.
+    let key = PatternKey::new(pattern, sx, sy, ctx.is_draft(), ctx.fast_filters);
+    let tile = match ctx.cache.pattern_tile(&key) {
+        Some(tile) => tile,
+        None => {
+            let tile = render_pattern_tile(pattern, ctx, sx, sy)?;
+            ctx.cache
+                .insert_pattern_tile(key, pattern.clone(), tile.clone());
+            tile
+        }
+    };
+
+    let rect = pattern.rect();
+    let mut ts = tiny_skia::Transform::default();
+    ts = ts.pre_concat(pattern.transform());
+    ts = ts.pre_translate(rect.x(), rect.y());
+    ts = ts.pre_scale(1.0 / tile.sx, 1.0 / tile.sy);
+
+    Some((tile.pixmap, ts))
+}
+
+fn render_pattern_tile(
+    pattern: &usvg::Pattern,
+    ctx: &Context,
+    sx: f32,
+    sy: f32,
+) -> Option<PatternTile> {
     let rect = pattern.rect();
     let img_size = tiny_skia::IntSize::from_wh(
         (rect.width() * sx).round() as u32,
@@ -192,13 +239,21 @@ fn render_pattern_pixmap(
     )?;
     let mut pixmap = tiny_skia::Pixmap::new(img_size.width(), img_size.height())?;
 
-    let transform = tiny_skia::Transform::from_scale(sx, sy);
-    crate::render::render_nodes(pattern.root(), ctx, transform, &mut pixmap.as_mut());
+    // Tiles are shared between renders, so they must not depend on the canvas.
+    let ctx = Context {
+        max_bbox: crate::max_bbox(img_size),
+        quality: ctx.quality,
+        fast_filters: ctx.fast_filters,
+        cache: ctx.cache,
+        approximate_images: ctx.approximate_images,
+    };
 
-    let mut ts = tiny_skia::Transform::default();
-    ts = ts.pre_concat(pattern.transform());
-    ts = ts.pre_translate(rect.x(), rect.y());
-    ts = ts.pre_scale(1.0 / sx, 1.0 / sy);
+    let transform = tiny_skia::Transform::from_scale(sx, sy);
+    crate::render::render_nodes(pattern.root(), &ctx, transform, &mut pixmap.as_mut());
 
-    Some((pixmap, ts))
+    Some(PatternTile {
+        pixmap: Arc::new(pixmap),
+        sx,
+        sy,
+    })
 }
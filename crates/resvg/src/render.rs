@@ -3,8 +3,20 @@
 
 use crate::OptionLog;
 
-pub struct Context {
+pub struct Context<'a> {
     pub max_bbox: tiny_skia::IntRect,
+    pub quality: crate::Quality,
+    pub fast_filters: bool,
+    pub cache: &'a crate::Cache,
+    /// See [`RenderOptions::approximate_images`](crate::RenderOptions::approximate_images).
+    pub approximate_images: bool,
+}
+
+impl Context<'_> {
+    #[inline]
+    pub fn is_draft(&self) -> bool {
+        self.quality == crate::Quality::Draft
+    }
 }
 
 pub fn render_nodes(
@@ -13,11 +25,35 @@ pub fn render_nodes(
     transform: tiny_skia::Transform,
     pixmap: &mut tiny_skia::PixmapMut,
 ) {
-    for node in parent.children() {
-        render_node(node, ctx, transform, pixmap);
+    match visible_rect(transform, pixmap) {
+        // Skip children that cannot touch the pixmap.
+        Some(rect) => parent.children_in_rect(rect, |node| {
+            render_node(node, ctx, transform, pixmap);
+        }),
+        None => {
+            for node in parent.children() {
+                render_node(node, ctx, transform, pixmap);
+            }
+        }
     }
 }
 
+/// Maps the pixmap area back into the coordinates `transform` is applied to.
+///
+/// The area is expanded by 2px to make sure that anti-aliased pixels would not be culled.
+fn visible_rect(
+    transform: tiny_skia::Transform,
+    pixmap: &tiny_skia::PixmapMut,
+) -> Option<tiny_skia::Rect> {
+    let rect = tiny_skia::NonZeroRect::from_xywh(
+        -2.0,
+        -2.0,
+        pixmap.width() as f32 + 4.0,
+        pixmap.height() as f32 + 4.0,
+    )?;
+    Some(rect.transform(transform.invert()?)?.to_rect())
+}
+
 pub fn render_node(
     node: &usvg::Node,
     ctx: &Context,
@@ -32,17 +68,21 @@ pub fn render_node(
             crate::path::render(
                 path,
                 tiny_skia::BlendMode::SourceOver,
+                usvg::Opacity::ONE,
                 ctx,
                 transform,
                 pixmap,
             );
         }
         usvg::Node::Image(ref image) => {
-            crate::image::render(image, transform, pixmap);
+            crate::image::render(image, ctx, transform, pixmap);
         }
         usvg::Node::Text(ref text) => {
             render_group(text.flattened(), ctx, transform, pixmap);
         }
+        usvg::Node::Instance(ref instance) => {
+            render_group(instance.root(), ctx, transform, pixmap);
+        }
     }
 }
 
@@ -59,6 +99,19 @@ fn render_group(
         return Some(());
     }
 
+    // A single shape can be rendered directly, without a layer.
+    if let Some((path, opacity, transform)) = fold_opacity(group, transform) {
+        crate::path::render(
+            path,
+            tiny_skia::BlendMode::SourceOver,
+            opacity,
+            ctx,
+            transform,
+            pixmap,
+        );
+        return Some(());
+    }
+
     let bbox = group.layer_bounding_box().transform(transform)?;
 
     let mut ibbox = if group.filters().is_empty() {
@@ -84,6 +137,12 @@ fn render_group(
     // This is required to prevent huge layers.
     if group.filters().is_empty() {
         ibbox = crate::geom::fit_to_rect(ibbox, ctx.max_bbox)?;
+
+        // Without filters, layer pixels outside the current canvas would never be visible,
+        // so there is no point in allocating them.
+        // This keeps layers bounded by the canvas size during strips rendering as well.
+        let canvas_rect = tiny_skia::IntRect::from_xywh(0, 0, pixmap.width(), pixmap.height())?;
+        ibbox = crate::geom::fit_to_rect(ibbox, canvas_rect)?;
     }
 
     let shift_ts = {
@@ -107,12 +166,12 @@ fn render_group(
 
     if !group.filters().is_empty() {
         for filter in group.filters() {
-            crate::filter::apply(filter, transform, &mut sub_pixmap);
+            crate::filter::apply(filter, ctx, transform, &mut sub_pixmap);
         }
     }
 
     if let Some(clip_path) = group.clip_path() {
-        crate::clip::apply(clip_path, transform, &mut sub_pixmap);
+        crate::clip::apply(clip_path, ctx, transform, &mut sub_pixmap);
     }
 
     if let Some(mask) = group.mask() {
@@ -137,6 +196,44 @@ fn render_group(
     Some(())
 }
 
+/// Checks that a group can be rendered without a layer.
+///
+/// This is the case when a group is isolated only because of its opacity
+/// and contains a single shape, either directly or through nested groups like this one.
+/// The shape must have either a fill or a stroke, since they would overlap otherwise.
+/// Such a shape can be rendered directly, with the group opacity applied to its paint.
+///
+/// `transform` should already include the group transform.
+fn fold_opacity(
+    mut group: &usvg::Group,
+    mut transform: tiny_skia::Transform,
+) -> Option<(&usvg::Path, usvg::Opacity, tiny_skia::Transform)> {
+    let mut opacity = usvg::Opacity::ONE;
+    loop {
+        if group.isolate()
+            || group.clip_path().is_some()
+            || group.mask().is_some()
+            || !group.filters().is_empty()
+            || group.blend_mode() != usvg::BlendMode::Normal
+        {
+            return None;
+        }
+
+        opacity = opacity * group.opacity();
+
+        match group.children() {
+            [usvg::Node::Group(ref child)] => {
+                transform = transform.pre_concat(child.transform());
+                group = child;
+            }
+            [usvg::Node::Path(ref path)] if path.fill().is_none() || path.stroke().is_none() => {
+                return Some((path, opacity, transform));
+            }
+            _ => return None,
+        }
+    }
+}
+
 pub fn convert_blend_mode(mode: usvg::BlendMode) -> tiny_skia::BlendMode {
     match mode {
         usvg::BlendMode::Normal => tiny_skia::BlendMode::SourceOver,
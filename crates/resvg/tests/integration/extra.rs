@@ -1,7 +1,9 @@
 // Copyright 2023 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
-use crate::{render_extra, render_extra_with_scale, render_node};
+use crate::{
+    load_tree, max_diff, mean_diff, render_extra, render_extra_with_scale, render_node, render_tree,
+};
 
 #[test]
 fn group_with_only_transform() {
@@ -80,3 +82,321 @@ fn render_node_filter_on_empty_group() {
 fn render_node_filter_with_transform_on_shape() {
     assert_eq!(render_node("extra/filter-with-transform-on-shape", "g1"), 0);
 }
+
+#[test]
+fn render_strips_match_full_render() {
+    let tree = load_tree("tests/extra/filter-region-precision.svg");
+    let full = render_tree(&tree, 4.0, &resvg::RenderOptions::default());
+
+    let size = full.size();
+    let ts = tiny_skia::Transform::from_scale(4.0, 4.0);
+    let strip_height = 7;
+    let row_len = size.width() as usize * tiny_skia::BYTES_PER_PIXEL;
+    let mut y = 0;
+    while y < size.height() {
+        let rows = strip_height.min(size.height() - y);
+        let mut strip = tiny_skia::Pixmap::new(size.width(), rows).unwrap();
+        resvg::render_strip(&tree, ts, size, y, &mut strip.as_mut());
+
+        // Shifting the tree by `y` can change float rounding on anti-aliased edges by one level.
+        let start = y as usize * row_len;
+        let expected = &full.data()[start..start + rows as usize * row_len];
+        assert!(max_diff(strip.data(), expected) <= 1, "strip at {}", y);
+
+        y += rows;
+    }
+}
+
+#[test]
+fn draft_render_approximates_full_render() {
+    let tree = load_tree("tests/filters/feGaussianBlur/simple-case.svg");
+    let full = render_tree(&tree, 1.5, &resvg::RenderOptions::default());
+
+    let options = resvg::RenderOptions {
+        quality: resvg::Quality::Draft,
+        ..resvg::RenderOptions::default()
+    };
+    let draft = render_tree(&tree, 1.5, &options);
+
+    let diff = mean_diff(draft.data(), full.data());
+    assert!(diff < 10.0, "mean difference is {}", diff);
+}
+
+#[test]
+fn shared_cache_matches_uncached_render() {
+    let cache = resvg::Cache::default();
+    let options = resvg::RenderOptions {
+        cache: Some(&cache),
+        ..resvg::RenderOptions::default()
+    };
+    let approximate_options = resvg::RenderOptions {
+        approximate_images: true,
+        ..options
+    };
+
+    for path in [
+        "tests/paint-servers/pattern/simple-case.svg",
+        "tests/structure/image/embedded-png.svg",
+        "tests/structure/image/embedded-svg.svg",
+    ] {
+        let tree = load_tree(path);
+
+        // Small enough to use downscaled images.
+        for scale in [1.0, 0.2] {
+            let uncached = render_tree(&tree, scale, &resvg::RenderOptions::default());
+
+            // The first render fills the cache, the second one uses cached results.
+            for _ in 0..2 {
+                let pixmap = render_tree(&tree, scale, &options);
+                assert!(pixmap.data() == uncached.data(), "{} at {}", path, scale);
+            }
+
+            // Mip levels and snapping can differ from an exact render slightly.
+            let expected = render_tree(&tree, scale, &approximate_options);
+            let diff = mean_diff(expected.data(), uncached.data());
+            assert!(diff < 1.0, "{} at {}: {}", path, scale, diff);
+
+            let pixmap = render_tree(&tree, scale, &approximate_options);
+            assert!(pixmap.data() == expected.data(), "{} at {}", path, scale);
+        }
+    }
+}
+
+#[test]
+fn cached_pattern_tiles_do_not_depend_on_canvas() {
+    let svg_data = "<svg xmlns='http://www.w3.org/2000/svg' width='200' height='200'>
+        <filter id='blur'><feGaussianBlur stdDeviation='5'/></filter>
+        <pattern id='pattern' width='100' height='100' patternUnits='userSpaceOnUse'>
+            <rect x='10' y='10' width='80' height='80' fill='seagreen' filter='url(#blur)'/>
+        </pattern>
+        <rect width='200' height='200' fill='url(#pattern)'/>
+    </svg>";
+    let tree = usvg::Tree::from_str(svg_data, &usvg::Options::default()).unwrap();
+    let expected = render_tree(&tree, 1.0, &resvg::RenderOptions::default());
+
+    let cache = resvg::Cache::default();
+    let options = resvg::RenderOptions {
+        cache: Some(&cache),
+        ..resvg::RenderOptions::default()
+    };
+
+    // A tile rendered for a tiny canvas must be reusable by a larger one.
+    let mut small = tiny_skia::Pixmap::new(10, 10).unwrap();
+    resvg::render_with_options(
+        &tree,
+        tiny_skia::Transform::default(),
+        &options,
+        &mut small.as_mut(),
+    );
+
+    let pixmap = render_tree(&tree, 1.0, &options);
+    assert!(pixmap.data() == expected.data());
+}
+
+#[test]
+fn nested_images_outside_canvas_are_not_cached() {
+    let tree = load_tree("tests/structure/image/embedded-svg.svg");
+
+    let cache = resvg::Cache::default();
+    let options = resvg::RenderOptions {
+        cache: Some(&cache),
+        ..resvg::RenderOptions::default()
+    };
+
+    let size = tree.size().to_int_size();
+    let mut pixmap = tiny_skia::Pixmap::new(size.width(), size.height()).unwrap();
+    let ts = tiny_skia::Transform::from_translate(-200.0, 0.0);
+    resvg::render_with_options(&tree, ts, &options, &mut pixmap.as_mut());
+    assert_eq!(cache.memory_usage(), 0);
+
+    render_tree(&tree, 1.0, &options);
+    assert!(cache.memory_usage() > 0);
+}
+
+#[test]
+fn decoded_images_are_reused() {
+    let tree = load_tree("tests/structure/image/embedded-png.svg");
+
+    let cache = resvg::Cache::default();
+    assert_eq!(cache.decode_images(&tree), 0);
+
+    let expected = render_tree(&tree, 1.0, &resvg::RenderOptions::default());
+
+    let options = resvg::RenderOptions {
+        cache: Some(&cache),
+        ..resvg::RenderOptions::default()
+    };
+    let pixmap = render_tree(&tree, 1.0, &options);
+    assert!(pixmap.data() == expected.data());
+}
+
+#[test]
+fn lazy_text_matches_eager_render() {
+    let lazy_opt = usvg::Options {
+        fontdb: crate::GLOBAL_FONTDB.clone(),
+        lazy_text: true,
+        ..usvg::Options::default()
+    };
+
+    for path in [
+        "tests/text/text/simple-case.svg",
+        "tests/text/text-decoration/all-types-inline.svg",
+        "tests/text/textPath/closed-path.svg",
+    ] {
+        let tree = load_tree(path);
+        let svg_data = std::fs::read(path).unwrap();
+        let lazy_tree = usvg::Tree::from_data(&svg_data, &lazy_opt).unwrap();
+
+        assert_eq!(
+            tree.root().abs_bounding_box(),
+            lazy_tree.root().abs_bounding_box(),
+            "{}",
+            path
+        );
+
+        let expected = render_tree(&tree, 1.0, &resvg::RenderOptions::default());
+        let pixmap = render_tree(&lazy_tree, 1.0, &resvg::RenderOptions::default());
+        assert!(pixmap.data() == expected.data(), "{}", path);
+    }
+}
+
+#[test]
+fn fast_filters_approximate_large_blurs() {
+    let svg_data = "<svg xmlns='http://www.w3.org/2000/svg' width='400' height='300'>
+        <filter id='filter' x='-50%' y='-50%' width='200%' height='200%'>
+            <feGaussianBlur stdDeviation='40'/>
+        </filter>
+        <filter id='shadow' x='-50%' y='-50%' width='200%' height='200%'>
+            <feDropShadow stdDeviation='24 48' dx='10' dy='20'/>
+        </filter>
+        <rect x='100' y='80' width='200' height='140' fill='seagreen' filter='url(#filter)'/>
+        <circle cx='200' cy='150' r='60' fill='coral' filter='url(#shadow)'/>
+    </svg>";
+    let tree = usvg::Tree::from_str(svg_data, &usvg::Options::default()).unwrap();
+    let full = render_tree(&tree, 1.0, &resvg::RenderOptions::default());
+
+    let options = resvg::RenderOptions {
+        fast_filters: true,
+        ..resvg::RenderOptions::default()
+    };
+    let fast = render_tree(&tree, 1.0, &options);
+
+    // The bound documented by `RenderOptions::fast_filters`.
+    let diff = max_diff(fast.data(), full.data());
+    assert!(diff <= 8, "max difference is {}", diff);
+}
+
+#[test]
+fn folded_group_opacity_matches_layer() {
+    let render = |isolation: &str| {
+        let svg_data = format!(
+            "<svg xmlns='http://www.w3.org/2000/svg' width='200' height='200'>
+                <linearGradient id='lg'>
+                    <stop offset='0' stop-color='gold'/>
+                    <stop offset='1' stop-color='navy' stop-opacity='0.5'/>
+                </linearGradient>
+                <g opacity='0.5' style='isolation:{0}'>
+                    <circle cx='70' cy='70' r='50' fill='seagreen' fill-opacity='0.8'/>
+                </g>
+                <g opacity='0.7' style='isolation:{0}'>
+                    <g opacity='0.6' transform='rotate(15 100 100)'>
+                        <rect x='60' y='60' width='120' height='80' fill='url(#lg)'/>
+                    </g>
+                </g>
+                <g opacity='0.4' style='isolation:{0}'>
+                    <path d='M 20 180 L 180 20' stroke='coral' stroke-width='12'/>
+                </g>
+            </svg>",
+            isolation
+        );
+        let tree = usvg::Tree::from_str(&svg_data, &usvg::Options::default()).unwrap();
+        render_tree(&tree, 1.0, &resvg::RenderOptions::default())
+    };
+
+    let folded = render("auto");
+    let layered = render("isolate");
+
+    let diff = max_diff(folded.data(), layered.data());
+    assert!(diff <= 2, "max difference is {}", diff);
+}
+
+#[test]
+fn culled_render_matches_full_render() {
+    let mut svg_data =
+        String::from("<svg xmlns='http://www.w3.org/2000/svg' width='200' height='200'>");
+    for y in 0..20 {
+        for x in 0..20 {
+            svg_data.push_str(&format!(
+                "<circle cx='{}' cy='{}' r='4' fill='seagreen' stroke='navy' stroke-width='3'/>",
+                x * 10 + 5,
+                y * 10 + 5
+            ));
+        }
+    }
+    svg_data.push_str(
+        "<g transform='rotate(30 100 100)' opacity='0.5'>
+            <rect x='40' y='90' width='120' height='20' fill='coral'/>
+        </g>
+        <filter id='blur'><feGaussianBlur stdDeviation='3'/></filter>
+        <rect x='88' y='80' width='8' height='8' fill='gold' filter='url(#blur)'/>
+    </svg>",
+    );
+    let tree = usvg::Tree::from_str(&svg_data, &usvg::Options::default()).unwrap();
+
+    let scale = tiny_skia::Transform::from_scale(4.0, 4.0);
+    let mut full = tiny_skia::Pixmap::new(800, 800).unwrap();
+    resvg::render(&tree, scale, &mut full.as_mut());
+
+    // Zoomed into a small area, so most of the shapes are outside the pixmap.
+    let (dx, dy) = (350, 310);
+    let mut view = tiny_skia::Pixmap::new(100, 100).unwrap();
+    let transform = scale.post_translate(-dx as f32, -dy as f32);
+    resvg::render(&tree, transform, &mut view.as_mut());
+
+    for y in 0..view.height() {
+        for x in 0..view.width() {
+            let a = view.pixel(x, y).unwrap();
+            let b = full.pixel(x + dx, y + dy).unwrap();
+            let diff = [
+                a.red().abs_diff(b.red()),
+                a.green().abs_diff(b.green()),
+                a.blue().abs_diff(b.blue()),
+                a.alpha().abs_diff(b.alpha()),
+            ];
+            assert!(
+                diff.iter().all(|d| *d <= 1),
+                "pixel at {}x{} differs: {:?} vs {:?}",
+                x,
+                y,
+                a,
+                b
+            );
+        }
+    }
+}
+
+#[test]
+fn optimized_tree_matches_original_render() {
+    let svg_data = "<svg xmlns='http://www.w3.org/2000/svg' width='200' height='200'>
+        <rect x='10' y='10' width='40' height='40' fill='seagreen'/>
+        <rect x='50' y='10' width='40' height='40' fill='seagreen'/>
+        <rect x='10.5' y='60.5' width='39' height='39' fill='seagreen'/>
+        <rect x='49.5' y='60.5' width='39' height='39' fill='seagreen'/>
+        <circle cx='150' cy='40' r='25' fill='coral'/>
+        <circle cx='150' cy='140' r='25' fill='coral'/>
+        <rect x='20' y='120' width='30' height='30' fill='navy'/>
+        <rect x='60' y='120' width='30' height='30' fill='navy'/>
+    </svg>";
+    let tree = usvg::Tree::from_str(svg_data, &usvg::Options::default()).unwrap();
+    let mut optimized = usvg::Tree::from_str(svg_data, &usvg::Options::default()).unwrap();
+    optimized.optimize();
+
+    // Touching rects are not merged with each other, while distant shapes are.
+    assert_eq!(optimized.root().children().len(), 5);
+
+    for scale in [1.0, 0.3, 2.5] {
+        let expected = render_tree(&tree, scale, &resvg::RenderOptions::default());
+        let pixmap = render_tree(&optimized, scale, &resvg::RenderOptions::default());
+        assert!(pixmap.data() == expected.data(), "at {}", scale);
+    }
+}
@@ -195,6 +195,51 @@ pub fn render_node(name: &str, id: &str) -> usize {
     pixels_d
 }
 
+/// Loads an SVG file using the test fonts.
+pub fn load_tree(path: &str) -> usvg::Tree {
+    let opt = usvg::Options {
+        fontdb: GLOBAL_FONTDB.clone(),
+        ..usvg::Options::default()
+    };
+
+    let svg_data = std::fs::read(path).unwrap();
+    usvg::Tree::from_data(&svg_data, &opt).unwrap()
+}
+
+/// Renders a tree scaled by `scale` onto a new pixmap of the matching size.
+pub fn render_tree(
+    tree: &usvg::Tree,
+    scale: f32,
+    options: &resvg::RenderOptions,
+) -> tiny_skia::Pixmap {
+    let size = tree.size().to_int_size().scale_by(scale).unwrap();
+    let mut pixmap = tiny_skia::Pixmap::new(size.width(), size.height()).unwrap();
+    let ts = tiny_skia::Transform::from_scale(scale, scale);
+    resvg::render_with_options(tree, ts, options, &mut pixmap.as_mut());
+    pixmap
+}
+
+/// Returns the largest difference between channels of two images.
+pub fn max_diff(a: &[u8], b: &[u8]) -> u32 {
+    assert_eq!(a.len(), b.len());
+    a.iter()
+        .zip(b)
+        .map(|(a, b)| (*a as i32 - *b as i32).unsigned_abs())
+        .max()
+        .unwrap_or(0)
+}
+
+/// Returns the mean difference between channels of two images.
+pub fn mean_diff(a: &[u8], b: &[u8]) -> f64 {
+    assert_eq!(a.len(), b.len());
+    let total: u64 = a
+        .iter()
+        .zip(b)
+        .map(|(a, b)| (*a as i32 - *b as i32).unsigned_abs() as u64)
+        .sum();
+    total as f64 / a.len() as f64
+}
+
 fn load_png(path: &str) -> Vec<u8> {
     let data = std::fs::read(path).unwrap();
     let mut decoder = png::Decoder::new(data.as_slice());
@@ -91,6 +91,9 @@ OPTIONS:
                                     option. [values: 1..4294967295 (inclusive)] [default: 100]
 
   --preserve-text                   Do not convert text into paths.
+  --optimize                        Simplifies the tree for faster rendering.
+                                    Removes invisible elements, redundant groups
+                                    and merges adjacent shapes with the same fill
   --id-prefix                       Adds a prefix to each ID attribute
   --indent INDENT                   Sets the XML nodes indent
                                     [values: none, 0, 1, 2, 3, 4, tabs] [default: 4]
@@ -129,6 +132,7 @@ struct Args {
     font_dirs: Vec<PathBuf>,
     skip_system_fonts: bool,
     preserve_text: bool,
+    optimize: bool,
     list_fonts: bool,
     default_width: u32,
     default_height: u32,
@@ -190,6 +194,7 @@ fn collect_args() -> Result<Args, pico_args::Error> {
         font_dirs: input.values_from_str("--use-fonts-dir")?,
         skip_system_fonts: input.contains("--skip-system-fonts"),
         preserve_text: input.contains("--preserve-text"),
+        optimize: input.contains("--optimize"),
         list_fonts: input.contains("--list-fonts"),
         default_width: input
             .opt_value_from_fn("--default-width", parse_length)?
@@ -432,6 +437,9 @@ fn process(args: Args) -> Result<(), String> {
         font_resolver: usvg::FontResolver::default(),
         fontdb: Arc::new(fontdb),
         style_sheet,
+        compiled_style_sheet: None,
+        lazy_text: false,
+        limits: usvg::Limits::default(),
     };
 
     let input_svg = match in_svg {
@@ -439,7 +447,10 @@ fn process(args: Args) -> Result<(), String> {
         InputFrom::File(ref path) => std::fs::read(path).map_err(|e| e.to_string()),
     }?;
 
-    let tree = usvg::Tree::from_data(&input_svg, &re_opt).map_err(|e| format!("{}", e))?;
+    let mut tree = usvg::Tree::from_data(&input_svg, &re_opt).map_err(|e| format!("{}", e))?;
+    if args.optimize {
+        tree.optimize();
+    }
 
     let xml_opt = usvg::WriteOptions {
         id_prefix: args.id_prefix,
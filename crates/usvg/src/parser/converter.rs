@@ -11,6 +11,7 @@ use fontdb::Database;
 use svgtypes::{Length, LengthUnit as Unit, PaintOrderKind, TransformOrigin};
 use tiny_skia_path::PathBuilder;
 
+use super::limits::Budget;
 use super::svgtree::{self, AId, EId, FromValue, SvgNode};
 use super::units::{self, convert_length};
 use super::{marker, Error, Options};
@@ -34,7 +35,6 @@ pub struct State<'a> {
     pub(crate) opt: &'a Options<'a>,
 }
 
-#[derive(Clone)]
 pub struct Cache {
     /// This fontdb is initialized from [`Options::fontdb`] and then populated
     /// over the course of conversion.
@@ -45,6 +45,14 @@ pub struct Cache {
     pub masks: HashMap<String, Arc<Mask>>,
     pub filters: HashMap<String, Arc<filter::Filter>>,
     pub paint: HashMap<String, Paint>,
+    /// Unique path data, keyed by content hash.
+    path_data: HashMap<u64, Vec<Arc<tiny_skia_path::Path>>>,
+    /// Converted `use` content, shared between identical instances.
+    pub(crate) instances: HashMap<super::use_node::InstanceKey, Arc<Group>>,
+    /// The number of `use` elements referencing an element, keyed by the element ID hash.
+    use_links: HashMap<u64, u32>,
+    /// Resources used so far, continued from the `svgtree` parsing.
+    pub(crate) budget: Budget,
 
     // used for ID generation
     all_ids: HashSet<u64>,
@@ -58,7 +66,7 @@ pub struct Cache {
 }
 
 impl Cache {
-    pub(crate) fn new(#[cfg(feature = "text")] fontdb: Arc<Database>) -> Self {
+    pub(crate) fn new(#[cfg(feature = "text")] fontdb: Arc<Database>, budget: Budget) -> Self {
         Self {
             #[cfg(feature = "text")]
             fontdb,
@@ -67,6 +75,10 @@ impl Cache {
             masks: HashMap::new(),
             filters: HashMap::new(),
             paint: HashMap::new(),
+            path_data: HashMap::new(),
+            instances: HashMap::new(),
+            use_links: HashMap::new(),
+            budget,
 
             all_ids: HashSet::new(),
             linear_gradient_index: 0,
@@ -79,6 +91,42 @@ impl Cache {
         }
     }
 
+    /// Returns previously seen path data identical to the provided one,
+    /// or remembers and returns the provided one.
+    ///
+    /// Allows all identical shapes in a document to reference the same data.
+    pub(crate) fn share_path_data(
+        &mut self,
+        path: Arc<tiny_skia_path::Path>,
+    ) -> Arc<tiny_skia_path::Path> {
+        let mut h = std::collections::hash_map::DefaultHasher::new();
+        for verb in path.verbs() {
+            (*verb as u8).hash(&mut h);
+        }
+        for p in path.points() {
+            p.x.to_bits().hash(&mut h);
+            p.y.to_bits().hash(&mut h);
+        }
+
+        let bucket = self.path_data.entry(h.finish()).or_default();
+        if let Some(prev) = bucket
+            .iter()
+            .find(|prev| prev.verbs() == path.verbs() && prev.points() == path.points())
+        {
+            return prev.clone();
+        }
+
+        bucket.push(path.clone());
+        path
+    }
+
+    /// Checks that an element is referenced by more than one `use` element.
+    pub(crate) fn has_multiple_uses(&self, id: &str) -> bool {
+        self.use_links
+            .get(&string_hash(id))
+            .map_or(false, |count| *count > 1)
+    }
+
     // TODO: macros?
     pub(crate) fn gen_linear_gradient_id(&mut self) -> NonEmptyString {
         loop {
@@ -283,7 +331,11 @@ impl SvgColorExt for svgtypes::Color {
 ///
 /// - If `Document` doesn't have an SVG node - returns an empty tree.
 /// - If `Document` doesn't have a valid size - returns `Error::InvalidSize`.
-pub(crate) fn convert_doc(svg_doc: &svgtree::Document, opt: &Options) -> Result<Tree, Error> {
+pub(crate) fn convert_doc(
+    svg_doc: &svgtree::Document,
+    opt: &Options,
+    budget: Budget,
+) -> Result<Tree, Error> {
     let svg = svg_doc.root_element();
     let (size, restore_viewbox) = resolve_svg_size(&svg, opt);
     let size = size?;
@@ -332,6 +384,7 @@ pub(crate) fn convert_doc(svg_doc: &svgtree::Document, opt: &Options) -> Result<
     let mut cache = Cache::new(
         #[cfg(feature = "text")]
         opt.fontdb.clone(),
+        budget,
     );
 
     for node in svg_doc.descendants() {
@@ -349,6 +402,13 @@ pub(crate) fn convert_doc(svg_doc: &svgtree::Document, opt: &Options) -> Result<
                 if !node.element_id().is_empty() {
                     cache.all_ids.insert(string_hash(node.element_id()));
                 }
+            } else if tag == EId::Use {
+                if let Some(link) = node.attribute::<SvgNode>(AId::Href) {
+                    *cache
+                        .use_links
+                        .entry(string_hash(link.element_id()))
+                        .or_default() += 1;
+                }
             }
         }
     }
@@ -372,11 +432,16 @@ pub(crate) fn convert_doc(svg_doc: &svgtree::Document, opt: &Options) -> Result<
         tree.root.children.push(Node::Group(Box::new(g)));
     }
 
+    if let Some(e) = cache.budget.take_error() {
+        return Err(e);
+    }
+
     // Clear cache to make sure that all `Arc<T>` objects have a single strong reference.
     cache.clip_paths.clear();
     cache.masks.clear();
     cache.filters.clear();
     cache.paint.clear();
+    cache.instances.clear();
 
     super::paint_server::update_paint_servers(
         &mut tree.root,
@@ -526,6 +591,11 @@ pub(crate) fn convert_element(node: SvgNode, state: &State, cache: &mut Cache, p
         return;
     }
 
+    // Once a limit is reached, the tree would be discarded anyway.
+    if !cache.budget.check_time() {
+        return;
+    }
+
     if tag_name == EId::Use {
         super::use_node::convert(node, state, cache, parent);
         return;
@@ -559,7 +629,7 @@ fn convert_element_impl(
         | EId::Polyline
         | EId::Polygon
         | EId::Path => {
-            if let Some(path) = super::shapes::convert(node, state) {
+            if let Some(path) = super::shapes::convert_shared(node, state, cache) {
                 convert_path(node, path, state, cache, parent);
             }
         }
@@ -635,7 +705,7 @@ fn convert_clip_path_elements_impl(
 ) {
     match tag_name {
         EId::Rect | EId::Circle | EId::Ellipse | EId::Polyline | EId::Polygon | EId::Path => {
-            if let Some(path) = super::shapes::convert(node, state) {
+            if let Some(path) = super::shapes::convert_shared(node, state, cache) {
                 convert_path(node, path, state, cache, parent);
             }
         }
@@ -723,6 +793,7 @@ pub(crate) fn convert_group(
         layer_bounding_box: NonZeroRect::from_xywh(0.0, 0.0, 1.0, 1.0).unwrap(),
         abs_layer_bounding_box: NonZeroRect::from_xywh(0.0, 0.0, 1.0, 1.0).unwrap(),
         children: Vec::new(),
+        spatial_index: Default::default(),
     };
     collect_children(cache, &mut g);
 
@@ -817,6 +888,10 @@ fn convert_path(
         return;
     }
 
+    if !cache.budget.add_path_points(tiny_skia_path.points().len()) {
+        return;
+    }
+
     let has_bbox = tiny_skia_path.bounds().width() > 0.0 && tiny_skia_path.bounds().height() > 0.0;
     let mut fill = super::style::resolve_fill(node, has_bbox, state, cache);
     let mut stroke = super::style::resolve_stroke(node, has_bbox, state, cache);
@@ -4,7 +4,6 @@
 //! A collection of SVG filters.
 
 use std::collections::HashSet;
-use std::str::FromStr;
 use std::sync::Arc;
 
 use strict_num::PositiveF32;
@@ -844,6 +843,7 @@ fn convert_image_inner(
                         Node::Path(ref mut path) => path.id.clear(),
                         Node::Image(ref mut image) => image.id.clear(),
                         Node::Text(ref mut text) => text.id.clear(),
+                        Node::Instance(_) => {}
                     }
                 }
             }
@@ -857,7 +857,12 @@ fn convert_image_inner(
     let href = fe.try_attribute(AId::Href).log_none(|| {
         log::warn!("The 'feImage' element lacks the 'xlink:href' attribute. Skipped.");
     })?;
-    let img_data = super::image::get_href_data(href, state)?;
+    let img_data = cache
+        .budget
+        .load_image(|| super::image::get_href_data(href, state))?;
+    if !cache.budget.add_image(&img_data) {
+        return None;
+    }
     let actual_size = img_data.actual_size()?;
 
     let aspect: AspectRatio = fe.attribute(AId::PreserveAspectRatio).unwrap_or_default();
@@ -923,7 +928,7 @@ fn convert_lighting_color(node: SvgNode) -> Color {
                 .0
         }
         Some(value) => {
-            if let Ok(c) = svgtypes::Color::from_str(value) {
+            if let Some(c) = node.try_attribute::<svgtypes::Color>(AId::LightingColor) {
                 c.split_alpha().0
             } else {
                 log::warn!("Failed to parse lighting-color value: '{}'.", value);
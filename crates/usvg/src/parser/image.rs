@@ -139,7 +139,10 @@ pub(crate) fn convert(
         .try_attribute(AId::Href)
         .log_none(|| log::warn!("Image lacks the 'xlink:href' attribute. Skipped."))?;
 
-    let kind = get_href_data(href, state)?;
+    let kind = cache.budget.load_image(|| get_href_data(href, state))?;
+    if !cache.budget.add_image(&kind) {
+        return None;
+    }
 
     let visibility: Visibility = node.find_attribute(AId::Visibility).unwrap_or_default();
     let visible = visibility == Visibility::Visible;
@@ -355,6 +358,7 @@ pub(crate) fn load_sub_svg(data: &[u8], opt: &Options) -> Option<ImageKind> {
                 (opt.font_resolver.select_fallback)(c, used_fonts, db)
             }),
         },
+        limits: opt.limits,
         ..Options::default()
     };
 
@@ -367,7 +371,7 @@ pub(crate) fn load_sub_svg(data: &[u8], opt: &Options) -> Option<ImageKind> {
         }
     };
 
-    Some(ImageKind::SVG(tree))
+    Some(ImageKind::SVG(Arc::new(tree)))
 }
 
 /// Fits size into a viewbox.
@@ -0,0 +1,291 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use std::cell::RefCell;
+use std::time::{Duration, Instant};
+
+use crate::{Error, ImageKind};
+
+/// Resource limits for parsing untrusted SVG data.
+///
+/// Exceeding any of them results in a corresponding [`Error`] instead of a tree.
+///
+/// The defaults are permissive and only protect against obviously malicious files.
+#[derive(Clone, Copy, Debug)]
+pub struct Limits {
+    /// The maximum number of SVG elements in the XML document.
+    ///
+    /// Elements from other namespaces are not counted.
+    ///
+    /// Default: 1_000_000
+    pub max_elements: usize,
+
+    /// The maximum number of nodes after `use` elements are expanded.
+    ///
+    /// Each `use` copies its referenced element, so a small document can still expand
+    /// into a huge one.
+    /// Nodes of nested SVG images are accounted as well.
+    ///
+    /// Default: 1_000_000
+    pub max_nodes: usize,
+
+    /// The maximum elements nesting depth, including `use` references.
+    ///
+    /// Default: 1024
+    pub max_depth: u32,
+
+    /// The maximum total number of points in all shapes, including `use` copies
+    /// and nested SVG images.
+    ///
+    /// Default: unlimited
+    pub max_path_points: usize,
+
+    /// The maximum total size of images data, in bytes.
+    ///
+    /// Nested SVG images are accounted by their decompressed size.
+    ///
+    /// Default: unlimited
+    pub max_image_bytes: usize,
+
+    /// The maximum time parsing can take, including nested SVG images.
+    ///
+    /// Checked periodically and after loading each image, so it can be exceeded slightly.
+    /// XML parsing itself is not interrupted, but it takes a small part of the total time.
+    ///
+    /// Default: `None`
+    pub timeout: Option<Duration>,
+}
+
+impl Default for Limits {
+    fn default() -> Self {
+        Limits {
+            max_elements: 1_000_000,
+            max_nodes: 1_000_000,
+            max_depth: 1024,
+            max_path_points: usize::MAX,
+            max_image_bytes: usize::MAX,
+            timeout: None,
+        }
+    }
+}
+
+/// How many checks to skip between reading the clock.
+const TIME_CHECK_INTERVAL: u32 = 64;
+
+thread_local! {
+    /// What is left of the budget of a document that is loading an image on this thread.
+    ///
+    /// Images are loaded by user-provided resolvers, which parse nested SVG images
+    /// via the public API, so the budget cannot be passed to them directly.
+    static NESTED: RefCell<Option<Nested>> = RefCell::new(None);
+}
+
+/// A budget shared with nested SVG images.
+struct Nested {
+    /// Limits left for nested images.
+    limits: Limits,
+    deadline: Option<Instant>,
+    /// Resources used by nested images.
+    nodes: usize,
+    path_points: usize,
+    image_bytes: usize,
+    /// The first limit exceeded by a nested image.
+    error: Option<Error>,
+}
+
+/// Tracks resources used during a single parsing.
+pub(crate) struct Budget {
+    limits: Limits,
+    deadline: Option<Instant>,
+    time_checks: u32,
+    nodes: usize,
+    path_points: usize,
+    image_bytes: usize,
+    /// Whether this is a nested SVG image budget, which is a part of its parent one.
+    is_nested: bool,
+    /// The first exceeded limit.
+    error: Option<Error>,
+}
+
+impl Budget {
+    /// Starts a new budget. The timeout is counted from this moment.
+    ///
+    /// When called while loading an image of another document, starts with what is left
+    /// of that document budget instead, and accounts `source_len` as image data.
+    pub fn new(limits: &Limits, source_len: usize) -> Self {
+        let mut budget = Budget {
+            limits: *limits,
+            deadline: limits.timeout.map(|t| Instant::now() + t),
+            time_checks: 0,
+            nodes: 0,
+            path_points: 0,
+            image_bytes: 0,
+            is_nested: false,
+            error: None,
+        };
+
+        NESTED.with(|nested| {
+            if let Some(ref nested) = *nested.borrow() {
+                budget.limits = nested.limits;
+                budget.deadline = match (budget.deadline, nested.deadline) {
+                    (Some(a), Some(b)) => Some(a.min(b)),
+                    (a, b) => a.or(b),
+                };
+                budget.is_nested = true;
+                budget.add_image_bytes(source_len);
+            }
+        });
+
+        budget
+    }
+
+    pub fn limits(&self) -> &Limits {
+        &self.limits
+    }
+
+    /// Checks that the deadline hasn't passed yet.
+    ///
+    /// Returns `false` when any limit has already been exceeded.
+    pub fn check_time(&mut self) -> bool {
+        if self.error.is_some() {
+            return false;
+        }
+
+        if let Some(deadline) = self.deadline {
+            self.time_checks += 1;
+            if self.time_checks % TIME_CHECK_INTERVAL == 0 && Instant::now() > deadline {
+                self.error = Some(Error::Timeout);
+                return false;
+            }
+        }
+
+        true
+    }
+
+    /// Accounts for a new path.
+    ///
+    /// Returns `false` when any limit has already been exceeded.
+    pub fn add_path_points(&mut self, count: usize) -> bool {
+        self.path_points = self.path_points.saturating_add(count);
+        if self.path_points > self.limits.max_path_points && self.error.is_none() {
+            self.error = Some(Error::PathPointsLimitReached);
+        }
+
+        self.error.is_none()
+    }
+
+    /// Accounts for the number of nodes in the document.
+    pub fn add_nodes(&mut self, count: usize) {
+        self.nodes = self.nodes.saturating_add(count);
+    }
+
+    /// Accounts for a new image.
+    ///
+    /// Nested SVG images are accounted by their own budget, via [`Budget::load_image`].
+    ///
+    /// Returns `false` when any limit has already been exceeded.
+    pub fn add_image(&mut self, kind: &ImageKind) -> bool {
+        match kind {
+            ImageKind::JPEG(ref data)
+            | ImageKind::PNG(ref data)
+            | ImageKind::GIF(ref data)
+            | ImageKind::WEBP(ref data) => self.add_image_bytes(data.len()),
+            ImageKind::SVG(_) => self.error.is_none(),
+        }
+    }
+
+    fn add_image_bytes(&mut self, size: usize) -> bool {
+        self.image_bytes = self.image_bytes.saturating_add(size);
+        if self.image_bytes > self.limits.max_image_bytes && self.error.is_none() {
+            self.error = Some(Error::ImageBytesLimitReached);
+        }
+
+        self.error.is_none()
+    }
+
+    /// Runs `load`, which may parse a nested SVG image, with what is left of this budget.
+    ///
+    /// Resources used by the nested image are added to this budget,
+    /// and a limit exceeded by it is exceeded by this document as well.
+    pub fn load_image<T>(&mut self, load: impl FnOnce() -> T) -> T {
+        let nested = Nested {
+            limits: Limits {
+                max_nodes: self.limits.max_nodes.saturating_sub(self.nodes),
+                max_path_points: self.limits.max_path_points.saturating_sub(self.path_points),
+                max_image_bytes: self.limits.max_image_bytes.saturating_sub(self.image_bytes),
+                ..self.limits
+            },
+            deadline: self.deadline,
+            nodes: 0,
+            path_points: 0,
+            image_bytes: 0,
+            error: None,
+        };
+
+        let prev = NESTED.with(|n| n.replace(Some(nested)));
+        let result = load();
+        if let Some(nested) = NESTED.with(|n| n.replace(prev)) {
+            self.nodes = self.nodes.saturating_add(nested.nodes);
+            self.path_points = self.path_points.saturating_add(nested.path_points);
+            self.image_bytes = self.image_bytes.saturating_add(nested.image_bytes);
+            if self.error.is_none() {
+                self.error = nested.error;
+            }
+        }
+
+        // Parsing an image can take a while, so do not wait for the next periodic check.
+        if let Some(deadline) = self.deadline {
+            if self.error.is_none() && Instant::now() > deadline {
+                self.error = Some(Error::Timeout);
+            }
+        }
+
+        result
+    }
+
+    /// Returns the first exceeded limit, if any.
+    pub fn take_error(&mut self) -> Option<Error> {
+        self.error.take()
+    }
+}
+
+impl Drop for Budget {
+    fn drop(&mut self) {
+        if !self.is_nested {
+            return;
+        }
+
+        NESTED.with(|nested| {
+            if let Some(ref mut nested) = *nested.borrow_mut() {
+                nested.nodes = nested.nodes.saturating_add(self.nodes);
+                nested.path_points = nested.path_points.saturating_add(self.path_points);
+                nested.image_bytes = nested.image_bytes.saturating_add(self.image_bytes);
+            }
+        });
+    }
+}
+
+/// Passes a limit error of a nested SVG image to the document loading it.
+///
+/// Otherwise, it would be ignored like any other failure to load an image.
+pub(crate) fn report_nested<T>(result: Result<T, Error>) -> Result<T, Error> {
+    if let Err(ref e) = result {
+        let limit_error = match e {
+            Error::ElementsLimitReached => Error::ElementsLimitReached,
+            Error::NodesLimitReached => Error::NodesLimitReached,
+            Error::DepthLimitReached => Error::DepthLimitReached,
+            Error::PathPointsLimitReached => Error::PathPointsLimitReached,
+            Error::ImageBytesLimitReached => Error::ImageBytesLimitReached,
+            Error::Timeout => Error::Timeout,
+            _ => return result,
+        };
+
+        NESTED.with(|nested| {
+            if let Some(ref mut nested) = *nested.borrow_mut() {
+                nested.error.get_or_insert(limit_error);
+            }
+        });
+    }
+
+    result
+}
@@ -5,6 +5,7 @@ mod clippath;
 mod converter;
 mod filter;
 mod image;
+mod limits;
 mod marker;
 mod mask;
 mod options;
@@ -20,7 +21,9 @@ mod use_node;
 mod text;
 
 pub use image::{ImageHrefDataResolverFn, ImageHrefResolver, ImageHrefStringResolverFn};
+pub use limits::Limits;
 pub use options::Options;
+pub use svgtree::CompiledStyleSheet;
 pub(crate) use svgtree::{AId, EId};
 
 /// List of all errors.
@@ -32,9 +35,24 @@ pub enum Error {
     /// Compressed SVG must use the GZip algorithm.
     MalformedGZip,
 
-    /// We do not allow SVG with more than 1_000_000 elements for security reasons.
+    /// SVG has more elements than [`Limits::max_elements`].
     ElementsLimitReached,
 
+    /// SVG has more nodes than [`Limits::max_nodes`] after `use` elements expansion.
+    NodesLimitReached,
+
+    /// SVG elements are nested deeper than [`Limits::max_depth`].
+    DepthLimitReached,
+
+    /// SVG paths have more points than [`Limits::max_path_points`].
+    PathPointsLimitReached,
+
+    /// SVG images are larger than [`Limits::max_image_bytes`].
+    ImageBytesLimitReached,
+
+    /// Parsing took longer than [`Limits::timeout`].
+    Timeout,
+
     /// SVG doesn't have a valid size.
     ///
     /// Occurs when width and/or height are <= 0.
@@ -64,6 +82,21 @@ impl std::fmt::Display for Error {
             Error::ElementsLimitReached => {
                 write!(f, "the maximum number of SVG elements has been reached")
             }
+            Error::NodesLimitReached => {
+                write!(f, "the maximum number of SVG nodes has been reached")
+            }
+            Error::DepthLimitReached => {
+                write!(f, "the maximum SVG elements nesting depth has been reached")
+            }
+            Error::PathPointsLimitReached => {
+                write!(f, "the maximum number of path points has been reached")
+            }
+            Error::ImageBytesLimitReached => {
+                write!(f, "the maximum size of images has been reached")
+            }
+            Error::Timeout => {
+                write!(f, "SVG parsing took too long")
+            }
             Error::InvalidSize => {
                 write!(f, "SVG has an invalid size")
             }
@@ -107,24 +140,65 @@ impl crate::Tree {
 
     /// Parses `Tree` from an SVG string.
     pub fn from_str(text: &str, opt: &Options) -> Result<Self, Error> {
+        let budget = limits::Budget::new(&opt.limits, text.len());
+        limits::report_nested(Self::from_str_impl(text, opt, budget))
+    }
+
+    fn from_str_impl(text: &str, opt: &Options, mut budget: limits::Budget) -> Result<Self, Error> {
+        if let Some(e) = budget.take_error() {
+            return Err(e);
+        }
+
         let xml_opt = roxmltree::ParsingOptions {
             allow_dtd: true,
             ..Default::default()
         };
 
-        let doc =
-            roxmltree::Document::parse_with_options(text, xml_opt).map_err(Error::ParsingFailed)?;
+        // `svgtree::Document` references only the input text and not the XML tree,
+        // so the XML tree can be freed before the conversion.
+        // This way, only one of them is kept in memory at a time.
+        let doc = {
+            let xml = roxmltree::Document::parse_with_options(text, xml_opt)
+                .map_err(Error::ParsingFailed)?;
+            parse_svgtree(&xml, opt, &mut budget)?
+        };
 
-        Self::from_xmltree(&doc, opt)
+        self::converter::convert_doc(&doc, opt, budget)
     }
 
     /// Parses `Tree` from `roxmltree::Document`.
     pub fn from_xmltree(doc: &roxmltree::Document, opt: &Options) -> Result<Self, Error> {
-        let doc = svgtree::Document::parse_tree(doc, opt.style_sheet.as_deref())?;
-        self::converter::convert_doc(&doc, opt)
+        let budget = limits::Budget::new(&opt.limits, doc.input_text().len());
+        limits::report_nested(Self::from_xmltree_impl(doc, opt, budget))
+    }
+
+    fn from_xmltree_impl(
+        doc: &roxmltree::Document,
+        opt: &Options,
+        mut budget: limits::Budget,
+    ) -> Result<Self, Error> {
+        if let Some(e) = budget.take_error() {
+            return Err(e);
+        }
+
+        let doc = parse_svgtree(doc, opt, &mut budget)?;
+        self::converter::convert_doc(&doc, opt, budget)
     }
 }
 
+fn parse_svgtree<'input>(
+    xml: &roxmltree::Document<'input>,
+    opt: &'input Options,
+    budget: &mut limits::Budget,
+) -> Result<svgtree::Document<'input>, Error> {
+    svgtree::Document::parse_tree(
+        xml,
+        opt.compiled_style_sheet.as_deref(),
+        opt.style_sheet.as_deref(),
+        budget,
+    )
+}
+
 /// Decompresses an SVGZ file.
 pub fn decompress_svgz(data: &[u8]) -> Result<Vec<u8>, Error> {
     use std::io::Read;
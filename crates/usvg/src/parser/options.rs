@@ -1,12 +1,14 @@
 // Copyright 2018 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
-#[cfg(feature = "text")]
 use std::sync::Arc;
 
 #[cfg(feature = "text")]
 use crate::FontResolver;
-use crate::{ImageHrefResolver, ImageRendering, ShapeRendering, Size, TextRendering};
+use crate::{
+    CompiledStyleSheet, ImageHrefResolver, ImageRendering, Limits, ShapeRendering, Size,
+    TextRendering,
+};
 
 /// Processing options.
 #[derive(Debug)]
@@ -98,6 +100,28 @@ pub struct Options<'a> {
     /// A CSS stylesheet that should be injected into the SVG. Can be used to overwrite
     /// certain attributes.
     pub style_sheet: Option<String>,
+    /// A parsed CSS stylesheet that should be injected into the SVG.
+    ///
+    /// Same as `style_sheet`, but is parsed only once and can be shared between
+    /// multiple options and threads.
+    /// Its rules come before the `style_sheet` ones.
+    pub compiled_style_sheet: Option<Arc<CompiledStyleSheet>>,
+    /// Defers text outlining until a text node is rendered.
+    ///
+    /// Text is still shaped and laid out during parsing, so text bounding boxes are exact,
+    /// but glyph outlines are extracted only on the first [`Text::flattened`](crate::Text::flattened)
+    /// call. Stroke bounding boxes of text are estimated from glyph bounding boxes instead.
+    ///
+    /// Makes parsing of text-heavy documents much cheaper when only their size,
+    /// bounding boxes or a part of them is needed.
+    ///
+    /// Default: false
+    #[cfg(feature = "text")]
+    pub lazy_text: bool,
+    /// Resource limits for parsing untrusted data.
+    ///
+    /// Default: see type's documentation for details
+    pub limits: Limits,
 }
 
 impl Default for Options<'_> {
@@ -119,6 +143,10 @@ impl Default for Options<'_> {
             #[cfg(feature = "text")]
             fontdb: Arc::new(fontdb::Database::new()),
             style_sheet: None,
+            compiled_style_sheet: None,
+            #[cfg(feature = "text")]
+            lazy_text: false,
+            limits: Limits::default(),
         }
     }
 }
@@ -1,7 +1,6 @@
 // Copyright 2018 the Resvg Authors
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
-use std::str::FromStr;
 use std::sync::Arc;
 
 use strict_num::PositiveF32;
@@ -298,7 +297,7 @@ fn convert_stops(grad: SvgNode) -> Vec<Stop> {
                     .find_attribute(AId::Color)
                     .unwrap_or_else(svgtypes::Color::black),
                 Some(value) => {
-                    if let Ok(c) = svgtypes::Color::from_str(value) {
+                    if let Some(c) = stop.try_attribute(AId::StopColor) {
                         c
                     } else {
                         log::warn!("Failed to parse stop-color value: '{}'.", value);
@@ -652,9 +651,12 @@ fn node_to_user_coordinates(
         }
         Node::Image(ref mut image) => {
             if let ImageKind::SVG(ref mut tree) = image.kind {
+                let tree = Arc::make_mut(tree);
                 update_paint_servers(&mut tree.root, context_transform, context_bbox, None, cache);
             }
         }
+        // Shared subtrees are updated once, when created.
+        Node::Instance(_) => {}
         Node::Text(ref mut text) => {
             // By the SVG spec, `tspan` doesn't have a bbox and uses the parent `text` bbox.
             // Therefore we have to use text's bbox when converting tspan and flatted text
@@ -743,14 +745,16 @@ fn node_to_user_coordinates(
                 }
             }
 
-            // 3.
-            update_paint_servers(
-                &mut text.flattened,
-                context_transform,
-                context_bbox,
-                Some(bbox),
-                cache,
-            );
+            // 3. Lazy texts are flattened from the already processed layouted elements.
+            if let Some(flattened) = text.flattened.get_mut() {
+                update_paint_servers(
+                    flattened,
+                    context_transform,
+                    context_bbox,
+                    Some(bbox),
+                    cache,
+                );
+            }
         }
     }
 }
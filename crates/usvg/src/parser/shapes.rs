@@ -23,8 +23,21 @@ pub(crate) fn convert(node: SvgNode, state: &converter::State) -> Option<Arc<Pat
     }
 }
 
+/// Like [`convert`], but identical shapes share the same data.
+pub(crate) fn convert_shared(
+    node: SvgNode,
+    state: &converter::State,
+    cache: &mut converter::Cache,
+) -> Option<Arc<Path>> {
+    convert(node, state).map(|path| cache.share_path_data(path))
+}
+
 pub(crate) fn convert_path(node: SvgNode) -> Option<Arc<Path>> {
-    let value: &str = node.attribute(AId::D)?;
+    // Parsed while building the document.
+    node.try_attribute(AId::D)
+}
+
+pub(crate) fn parse_path_data(value: &str) -> Option<Arc<Path>> {
     let mut builder = tiny_skia_path::PathBuilder::new();
     for segment in svgtypes::SimplifyingPathParser::from(value) {
         let segment = match segment {
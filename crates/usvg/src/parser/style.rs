@@ -133,9 +133,9 @@ fn convert_paint(
     cache: &mut converter::Cache,
 ) -> Option<(Paint, Option<ContextElement>)> {
     let value: &str = node.attribute(aid)?;
-    let paint = match svgtypes::Paint::from_str(value) {
-        Ok(v) => v,
-        Err(_) => {
+    let paint = match node.try_attribute::<svgtypes::Paint>(aid) {
+        Some(v) => v,
+        None => {
             if aid == AId::Fill {
                 log::warn!(
                     "Failed to parse fill value: '{}'. Fallback to black.",
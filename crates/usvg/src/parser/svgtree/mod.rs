@@ -4,6 +4,7 @@
 use std::collections::HashMap;
 use std::num::NonZeroU32;
 use std::str::FromStr;
+use std::sync::Arc;
 
 #[rustfmt::skip] mod names;
 mod parse;
@@ -16,6 +17,7 @@ use crate::{
     Visibility,
 };
 pub use names::{AId, EId};
+pub use parse::CompiledStyleSheet;
 
 /// An SVG tree container.
 ///
@@ -24,6 +26,14 @@ pub use names::{AId, EId};
 pub struct Document<'input> {
     nodes: Vec<NodeData>,
     attrs: Vec<Attribute<'input>>,
+    /// Pre-parsed length attributes.
+    lengths: Vec<svgtypes::Length>,
+    /// Pre-parsed `transform`-like attributes.
+    transforms: Vec<Transform>,
+    /// Pre-parsed `fill` and `stroke` attributes.
+    paints: Vec<ParsedPaint>,
+    /// Pre-parsed `d` attributes.
+    paths: Vec<Arc<tiny_skia_path::Path>>,
     links: HashMap<String, NodeId>,
 }
 
@@ -206,6 +216,103 @@ pub struct Attribute<'input> {
     pub value: roxmltree::StringStorage<'input>,
     /// Attribute's importance
     pub important: bool,
+    /// Attribute's pre-parsed value.
+    pub parsed: ParsedValue,
+}
+
+/// A pre-parsed attribute value.
+///
+/// Attributes are often accessed multiple times and via ancestors,
+/// so they are parsed once, while building the document.
+/// The original string is still preserved.
+///
+/// Values larger than a color are stored by the document and referenced by index,
+/// which keeps an attribute at 40 bytes instead of 32 without a parsed value.
+#[derive(Clone, Copy, Debug)]
+pub enum ParsedValue {
+    /// The attribute is not pre-parsed or has an invalid value.
+    None,
+    /// An index in `Document::lengths`.
+    ///
+    /// A number is a length without units.
+    Length(u32),
+    /// An index in `Document::transforms`.
+    Transform(u32),
+    /// A color.
+    Color(svgtypes::Color),
+    /// An index in `Document::paints`.
+    Paint(u32),
+    /// An index in `Document::paths`.
+    Path(u32),
+}
+
+/// A pre-parsed `svgtypes::Paint`.
+///
+/// Unlike `svgtypes::Paint`, doesn't borrow the attribute value,
+/// so a link is stored as a range in it instead.
+#[derive(Clone, Copy, Debug)]
+pub(crate) enum ParsedPaint {
+    Paint(svgtypes::Paint<'static>),
+    FuncIRI(u32, u32, Option<svgtypes::PaintFallback>),
+}
+
+impl ParsedValue {
+    /// Returns attributes that should be pre-parsed as lengths.
+    fn is_length(aid: AId) -> bool {
+        matches!(
+            aid,
+            AId::Cx
+                | AId::Cy
+                | AId::FillOpacity
+                | AId::FloodOpacity
+                | AId::FontSize
+                | AId::Fr
+                | AId::Fx
+                | AId::Fy
+                | AId::Height
+                | AId::MarkerHeight
+                | AId::MarkerWidth
+                | AId::Opacity
+                | AId::R
+                | AId::RefX
+                | AId::RefY
+                | AId::Rx
+                | AId::Ry
+                | AId::StopOpacity
+                | AId::StrokeDashoffset
+                | AId::StrokeMiterlimit
+                | AId::StrokeOpacity
+                | AId::StrokeWidth
+                | AId::Width
+                | AId::X
+                | AId::X1
+                | AId::X2
+                | AId::Y
+                | AId::Y1
+                | AId::Y2
+        )
+    }
+
+    /// Returns attributes that should be pre-parsed as transforms.
+    fn is_transform(aid: AId) -> bool {
+        matches!(
+            aid,
+            AId::Transform | AId::GradientTransform | AId::PatternTransform
+        )
+    }
+
+    /// Returns attributes that should be pre-parsed as colors.
+    fn is_color(aid: AId) -> bool {
+        matches!(
+            aid,
+            AId::Color | AId::FloodColor | AId::LightingColor | AId::StopColor
+        )
+    }
+
+    /// Returns attributes that should be pre-parsed as paints.
+    fn is_paint(aid: AId) -> bool {
+        matches!(aid, AId::Fill | AId::Stroke)
+    }
 }
 
 impl std::fmt::Debug for Attribute<'_> {
@@ -277,16 +384,12 @@ impl<'a, 'input: 'a> SvgNode<'a, 'input> {
 
     /// Returns an attribute value.
     pub fn attribute<T: FromValue<'a, 'input>>(&self, aid: AId) -> Option<T> {
-        let value = self
-            .attributes()
-            .iter()
-            .find(|a| a.name == aid)
-            .map(|a| a.value.as_str())?;
-        match T::parse(*self, aid, value) {
+        let attr = self.attributes().iter().find(|a| a.name == aid)?;
+        match T::parse_attribute(*self, attr) {
             Some(v) => Some(v),
             None => {
                 // TODO: show position in XML
-                log::warn!("Failed to parse {} value: '{}'.", aid, value);
+                log::warn!("Failed to parse {} value: '{}'.", aid, attr.value.as_str());
                 None
             }
         }
@@ -296,12 +399,8 @@ impl<'a, 'input: 'a> SvgNode<'a, 'input> {
     ///
     /// Same as `SvgNode::attribute`, but doesn't show a warning.
     pub fn try_attribute<T: FromValue<'a, 'input>>(&self, aid: AId) -> Option<T> {
-        let value = self
-            .attributes()
-            .iter()
-            .find(|a| a.name == aid)
-            .map(|a| a.value.as_str())?;
-        T::parse(*self, aid, value)
+        let attr = self.attributes().iter().find(|a| a.name == aid)?;
+        T::parse_attribute(*self, attr)
     }
 
     #[inline]
@@ -741,7 +840,7 @@ impl AId {
     }
 
     /// Checks if the current attribute is inheritable.
-    fn is_inheritable(&self) -> bool {
+    pub(crate) fn is_inheritable(&self) -> bool {
         if self.is_presentation() {
             !is_non_inheritable(*self)
         } else {
@@ -834,6 +933,13 @@ pub trait FromValue<'a, 'input: 'a>: Sized {
     ///
     /// When `None` is returned, the attribute value will be logged as a parsing failure.
     fn parse(node: SvgNode<'a, 'input>, aid: AId, value: &'a str) -> Option<Self>;
+
+    /// Parses an attribute.
+    ///
+    /// Types that can be pre-parsed should use [`Attribute::parsed`] when possible.
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        Self::parse(node, attr.name, attr.value.as_str())
+    }
 }
 
 impl<'a, 'input: 'a> FromValue<'a, 'input> for &'a str {
@@ -846,52 +952,97 @@ impl<'a, 'input: 'a> FromValue<'a, 'input> for f32 {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
         svgtypes::Number::from_str(value).ok().map(|v| v.0 as f32)
     }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            // A number is a length without units.
+            ParsedValue::Length(idx) => {
+                let length = node.document().lengths[idx as usize];
+                // A number is a length without units.
+                if length.unit == svgtypes::LengthUnit::None {
+                    Some(length.number as f32)
+                } else {
+                    Self::parse(node, attr.name, attr.value.as_str())
+                }
+            }
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
+        }
+    }
 }
 
 impl<'a, 'input: 'a> FromValue<'a, 'input> for svgtypes::Length {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
         svgtypes::Length::from_str(value).ok()
     }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Length(idx) => Some(node.document().lengths[idx as usize]),
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
+        }
+    }
 }
 
 // TODO: to svgtypes?
 impl<'a, 'input: 'a> FromValue<'a, 'input> for Opacity {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
         let length = svgtypes::Length::from_str(value).ok()?;
-        if length.unit == svgtypes::LengthUnit::Percent {
-            Some(Opacity::new_clamped(length.number as f32 / 100.0))
-        } else if length.unit == svgtypes::LengthUnit::None {
-            Some(Opacity::new_clamped(length.number as f32))
-        } else {
-            None
+        length_to_opacity(length)
+    }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Length(idx) => length_to_opacity(node.document().lengths[idx as usize]),
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
         }
     }
 }
 
+fn length_to_opacity(length: svgtypes::Length) -> Option<Opacity> {
+    if length.unit == svgtypes::LengthUnit::Percent {
+        Some(Opacity::new_clamped(length.number as f32 / 100.0))
+    } else if length.unit == svgtypes::LengthUnit::None {
+        Some(Opacity::new_clamped(length.number as f32))
+    } else {
+        None
+    }
+}
+
 impl<'a, 'input: 'a> FromValue<'a, 'input> for Transform {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
-        let ts = match svgtypes::Transform::from_str(value) {
-            Ok(v) => v,
-            Err(_) => return None,
-        };
-
-        let ts = Transform::from_row(
-            ts.a as f32,
-            ts.b as f32,
-            ts.c as f32,
-            ts.d as f32,
-            ts.e as f32,
-            ts.f as f32,
-        );
-
-        if ts.is_valid() {
-            Some(ts)
-        } else {
-            Some(Transform::default())
+        parse_transform(value)
+    }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Transform(idx) => Some(node.document().transforms[idx as usize]),
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
         }
     }
 }
 
+fn parse_transform(value: &str) -> Option<Transform> {
+    let ts = match svgtypes::Transform::from_str(value) {
+        Ok(v) => v,
+        Err(_) => return None,
+    };
+
+    let ts = Transform::from_row(
+        ts.a as f32,
+        ts.b as f32,
+        ts.c as f32,
+        ts.d as f32,
+        ts.e as f32,
+        ts.f as f32,
+    );
+
+    if ts.is_valid() {
+        Some(ts)
+    } else {
+        Some(Transform::default())
+    }
+}
+
 impl<'a, 'input: 'a> FromValue<'a, 'input> for svgtypes::TransformOrigin {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
         Self::from_str(value).ok()
@@ -930,6 +1081,13 @@ impl<'a, 'input: 'a> FromValue<'a, 'input> for svgtypes::Color {
     fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
         Self::from_str(value).ok()
     }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Color(color) => Some(color),
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
+        }
+    }
 }
 
 impl<'a, 'input: 'a> FromValue<'a, 'input> for svgtypes::Angle {
@@ -948,6 +1106,32 @@ impl<'a, 'input: 'a> FromValue<'a, 'input> for svgtypes::Paint<'a> {
     fn parse(_: SvgNode, _: AId, value: &'a str) -> Option<Self> {
         Self::from_str(value).ok()
     }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Paint(idx) => match node.document().paints[idx as usize] {
+                ParsedPaint::Paint(paint) => Some(paint),
+                ParsedPaint::FuncIRI(start, end, fallback) => Some(svgtypes::Paint::FuncIRI(
+                    attr.value.as_str().get(start as usize..end as usize)?,
+                    fallback,
+                )),
+            },
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
+        }
+    }
+}
+
+impl<'a, 'input: 'a> FromValue<'a, 'input> for Arc<tiny_skia_path::Path> {
+    fn parse(_: SvgNode, _: AId, value: &str) -> Option<Self> {
+        super::shapes::parse_path_data(value)
+    }
+
+    fn parse_attribute(node: SvgNode<'a, 'input>, attr: &'a Attribute<'input>) -> Option<Self> {
+        match attr.parsed {
+            ParsedValue::Path(idx) => Some(node.document().paths[idx as usize].clone()),
+            _ => Self::parse(node, attr.name, attr.value.as_str()),
+        }
+    }
 }
 
 impl<'a, 'input: 'a> FromValue<'a, 'input> for Vec<f32> {
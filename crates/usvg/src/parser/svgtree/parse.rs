@@ -2,12 +2,16 @@
 // SPDX-License-Identifier: Apache-2.0 OR MIT
 
 use std::collections::HashMap;
+use std::str::FromStr;
 
-use roxmltree::Error;
 use simplecss::Declaration;
 use svgtypes::FontShorthand;
 
-use super::{AId, Attribute, Document, EId, NodeData, NodeId, NodeKind, ShortRange};
+use super::{
+    AId, Attribute, Document, EId, NodeData, NodeId, NodeKind, ParsedPaint, ParsedValue, ShortRange,
+};
+use crate::parser::limits::Budget;
+use crate::Error;
 
 const SVG_NS: &str = "http://www.w3.org/2000/svg";
 const XLINK_NS: &str = "http://www.w3.org/1999/xlink";
@@ -17,9 +21,11 @@ impl<'input> Document<'input> {
     /// Parses a [`Document`] from a [`roxmltree::Document`].
     pub fn parse_tree(
         xml: &roxmltree::Document<'input>,
+        compiled_stylesheet: Option<&CompiledStyleSheet>,
         injected_stylesheet: Option<&'input str>,
+        budget: &mut Budget,
     ) -> Result<Document<'input>, Error> {
-        parse(xml, injected_stylesheet)
+        parse(xml, compiled_stylesheet, injected_stylesheet, budget)
     }
 
     pub(crate) fn append(&mut self, parent_id: NodeId, kind: NodeKind) -> NodeId {
@@ -54,27 +60,90 @@ impl<'input> Document<'input> {
         value: roxmltree::StringStorage<'input>,
         important: bool,
     ) {
+        let parsed = self.parse_value(name, &value);
         self.attrs.push(Attribute {
             name,
             value,
             important,
+            parsed,
         });
     }
+
+    fn parse_value(&mut self, aid: AId, value: &str) -> ParsedValue {
+        if ParsedValue::is_length(aid) {
+            if let Ok(length) = svgtypes::Length::from_str(value) {
+                self.lengths.push(length);
+                return ParsedValue::Length(self.lengths.len() as u32 - 1);
+            }
+        } else if ParsedValue::is_transform(aid) {
+            if let Some(ts) = super::parse_transform(value) {
+                self.transforms.push(ts);
+                return ParsedValue::Transform(self.transforms.len() as u32 - 1);
+            }
+        } else if ParsedValue::is_color(aid) {
+            if let Ok(color) = svgtypes::Color::from_str(value) {
+                return ParsedValue::Color(color);
+            }
+        } else if ParsedValue::is_paint(aid) {
+            if let Some(paint) = parse_paint(value) {
+                self.paints.push(paint);
+                return ParsedValue::Paint(self.paints.len() as u32 - 1);
+            }
+        } else if aid == AId::D {
+            if let Some(path) = crate::parser::shapes::parse_path_data(value) {
+                self.paths.push(path);
+                return ParsedValue::Path(self.paths.len() as u32 - 1);
+            }
+        }
+
+        ParsedValue::None
+    }
+}
+
+fn parse_paint(value: &str) -> Option<ParsedPaint> {
+    let paint = match svgtypes::Paint::from_str(value).ok()? {
+        svgtypes::Paint::None => svgtypes::Paint::None,
+        svgtypes::Paint::Inherit => svgtypes::Paint::Inherit,
+        svgtypes::Paint::CurrentColor => svgtypes::Paint::CurrentColor,
+        svgtypes::Paint::Color(color) => svgtypes::Paint::Color(color),
+        svgtypes::Paint::ContextFill => svgtypes::Paint::ContextFill,
+        svgtypes::Paint::ContextStroke => svgtypes::Paint::ContextStroke,
+        svgtypes::Paint::FuncIRI(link, fallback) => {
+            // A link is always a substring of the value.
+            let start = link.as_ptr() as usize - value.as_ptr() as usize;
+            let end = start + link.len();
+            return Some(ParsedPaint::FuncIRI(start as u32, end as u32, fallback));
+        }
+    };
+
+    Some(ParsedPaint::Paint(paint))
 }
 
 fn parse<'input>(
     xml: &roxmltree::Document<'input>,
+    compiled_stylesheet: Option<&CompiledStyleSheet>,
     injected_stylesheet: Option<&'input str>,
+    budget: &mut Budget,
 ) -> Result<Document<'input>, Error> {
-    let mut doc = Document {
-        nodes: Vec::new(),
-        attrs: Vec::new(),
-        links: HashMap::new(),
-    };
-
     // build a map of id -> node for resolve_href
+    // and count elements and attributes along the way
     let mut id_map = HashMap::new();
+    let mut elements_count = 0;
+    let mut svg_elements_count = 0;
+    let mut attributes_count = 0;
     for node in xml.descendants() {
+        if !node.is_element() {
+            continue;
+        }
+
+        elements_count += 1;
+        attributes_count += node.attributes().len();
+
+        // Elements from other namespaces are never converted, so they are not limited.
+        if parse_tag_name(node).is_some() {
+            svg_elements_count += 1;
+        }
+
         if let Some(id) = node.attribute("id") {
             if !id_map.contains_key(id) {
                 id_map.insert(id, node);
@@ -82,6 +151,23 @@ fn parse<'input>(
         }
     }
 
+    if svg_elements_count > budget.limits().max_elements {
+        return Err(Error::ElementsLimitReached);
+    }
+
+    // Reserve the memory upfront, since the growth of huge vectors would require
+    // twice as much memory while copying.
+    // This is only an estimate, since `use` and CSS can add more nodes and attributes.
+    let mut doc = Document {
+        nodes: Vec::with_capacity(elements_count + 1),
+        attrs: Vec::with_capacity(attributes_count),
+        lengths: Vec::new(),
+        transforms: Vec::new(),
+        paints: Vec::new(),
+        paths: Vec::new(),
+        links: HashMap::new(),
+    };
+
     // Add a root node.
     doc.nodes.push(NodeData {
         parent: None,
@@ -90,7 +176,7 @@ fn parse<'input>(
         kind: NodeKind::Root,
     });
 
-    let style_sheet = resolve_css(xml, injected_stylesheet);
+    let style_sheet = resolve_css(xml, compiled_stylesheet, injected_stylesheet);
 
     parse_xml_node_children(
         xml.root(),
@@ -101,20 +187,22 @@ fn parse<'input>(
         0,
         &mut doc,
         &id_map,
+        budget,
     )?;
+    budget.add_nodes(doc.nodes.len());
 
     // Check that the root element is `svg`.
     match doc.root().first_element_child() {
         Some(child) => {
             if child.tag_name() != Some(EId::Svg) {
-                return Err(roxmltree::Error::NoRootNode);
+                return Err(Error::ParsingFailed(roxmltree::Error::NoRootNode));
             }
         }
-        None => return Err(roxmltree::Error::NoRootNode),
+        None => return Err(Error::ParsingFailed(roxmltree::Error::NoRootNode)),
     }
 
     // Collect all elements with `id` attribute.
-    let mut links = HashMap::new();
+    let mut links = HashMap::with_capacity(id_map.len());
     for node in doc.descendants() {
         if let Some(id) = node.attribute::<&str>(AId::Id) {
             links.insert(id.to_string(), node.id);
@@ -147,11 +235,12 @@ fn parse_xml_node_children<'input>(
     parent: roxmltree::Node<'_, 'input>,
     origin: roxmltree::Node,
     parent_id: NodeId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
     ignore_ids: bool,
     depth: u32,
     doc: &mut Document<'input>,
     id_map: &HashMap<&str, roxmltree::Node<'_, 'input>>,
+    budget: &mut Budget,
 ) -> Result<(), Error> {
     for node in parent.children() {
         parse_xml_node(
@@ -163,6 +252,7 @@ fn parse_xml_node_children<'input>(
             depth,
             doc,
             id_map,
+            budget,
         )?;
     }
 
@@ -173,14 +263,19 @@ fn parse_xml_node<'input>(
     node: roxmltree::Node<'_, 'input>,
     origin: roxmltree::Node,
     parent_id: NodeId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
     ignore_ids: bool,
     depth: u32,
     doc: &mut Document<'input>,
     id_map: &HashMap<&str, roxmltree::Node<'_, 'input>>,
+    budget: &mut Budget,
 ) -> Result<(), Error> {
-    if depth > 1024 {
-        return Err(Error::NodesLimitReached);
+    if depth > budget.limits().max_depth {
+        return Err(Error::DepthLimitReached);
+    }
+
+    if !budget.check_time() {
+        return Err(budget.take_error().unwrap_or(Error::Timeout));
     }
 
     let mut tag_name = match parse_tag_name(node) {
@@ -198,11 +293,28 @@ fn parse_xml_node<'input>(
         tag_name = EId::G;
     }
 
-    let node_id = parse_svg_element(node, parent_id, tag_name, style_sheet, ignore_ids, doc)?;
+    let node_id = parse_svg_element(
+        node,
+        parent_id,
+        tag_name,
+        style_sheet,
+        ignore_ids,
+        doc,
+        budget,
+    )?;
     if tag_name == EId::Text {
-        super::text::parse_svg_text_element(node, node_id, style_sheet, doc)?;
+        super::text::parse_svg_text_element(node, node_id, style_sheet, depth + 1, doc, budget)?;
     } else if tag_name == EId::Use {
-        parse_svg_use_element(node, origin, node_id, style_sheet, depth + 1, doc, id_map)?;
+        parse_svg_use_element(
+            node,
+            origin,
+            node_id,
+            style_sheet,
+            depth + 1,
+            doc,
+            id_map,
+            budget,
+        )?;
     } else {
         parse_xml_node_children(
             node,
@@ -213,6 +325,7 @@ fn parse_xml_node<'input>(
             depth + 1,
             doc,
             id_map,
+            budget,
         )?;
     }
 
@@ -223,9 +336,10 @@ pub(crate) fn parse_svg_element<'input>(
     xml_node: roxmltree::Node<'_, 'input>,
     parent_id: NodeId,
     tag_name: EId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
     ignore_ids: bool,
     doc: &mut Document<'input>,
+    budget: &Budget,
 ) -> Result<NodeId, Error> {
     let attrs_start_idx = doc.attrs.len();
 
@@ -374,12 +488,8 @@ pub(crate) fn parse_svg_element<'input>(
     };
 
     // Apply CSS.
-    for rule in &style_sheet.rules {
-        if rule.selector.matches(&XmlNode(xml_node)) {
-            for declaration in &rule.declarations {
-                write_declaration(declaration);
-            }
-        }
+    for declaration in style_sheet.matching_rules(xml_node) {
+        write_declaration(&declaration);
     }
 
     // Split a `style` attribute.
@@ -389,7 +499,7 @@ pub(crate) fn parse_svg_element<'input>(
         }
     }
 
-    if doc.nodes.len() > 1_000_000 {
+    if doc.nodes.len() > budget.limits().max_nodes {
         return Err(Error::NodesLimitReached);
     }
 
@@ -454,6 +564,7 @@ fn resolve_inherit(parent_id: NodeId, aid: AId, doc: &mut Document) -> bool {
                     name: aid,
                     value: attr.value,
                     important: attr.important,
+                    parsed: attr.parsed,
                 });
 
                 return true;
@@ -472,6 +583,7 @@ fn resolve_inherit(parent_id: NodeId, aid: AId, doc: &mut Document) -> bool {
                 name: aid,
                 value: attr.value,
                 important: attr.important,
+                parsed: attr.parsed,
             });
 
             return true;
@@ -547,10 +659,11 @@ fn parse_svg_use_element<'input>(
     node: roxmltree::Node<'_, 'input>,
     origin: roxmltree::Node,
     parent_id: NodeId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
     depth: u32,
     doc: &mut Document<'input>,
     id_map: &HashMap<&str, roxmltree::Node<'_, 'input>>,
+    budget: &mut Budget,
 ) -> Result<(), Error> {
     let link = match resolve_href(node, id_map) {
         Some(v) => v,
@@ -618,17 +731,17 @@ fn parse_svg_use_element<'input>(
         depth + 1,
         doc,
         id_map,
+        budget,
     )
 }
 
 fn resolve_css<'a>(
     xml: &'a roxmltree::Document<'a>,
+    compiled_style_sheet: Option<&'a CompiledStyleSheet>,
     style_sheet: Option<&'a str>,
-) -> simplecss::StyleSheet<'a> {
+) -> StyleSheet<'a> {
     let mut sheet = simplecss::StyleSheet::new();
 
-    // Injected style sheets do not override internal ones (we mimic the logic of rsvg-convert),
-    // so we need to parse it first.
     if let Some(style_sheet) = style_sheet {
         sheet.parse_more(style_sheet);
     }
@@ -648,7 +761,479 @@ fn resolve_css<'a>(
         sheet.parse_more(text);
     }
 
-    sheet
+    // `simplecss::StyleSheet` keeps rules sorted by specificity already.
+    let rules = sheet
+        .rules
+        .into_iter()
+        .map(|rule| StyleRule {
+            key: RuleKey::new(&rule.selector),
+            specificity: rule.selector.specificity(),
+            selector: rule.selector,
+            declarations: rule.declarations,
+        })
+        .collect();
+
+    StyleSheet::new(compiled_style_sheet, rules)
+}
+
+/// A parsed CSS stylesheet.
+///
+/// Can be injected into any number of documents via [`Options::compiled_style_sheet`](crate::Options::compiled_style_sheet)
+/// without being parsed again.
+#[derive(Clone, Debug)]
+pub struct CompiledStyleSheet {
+    /// Sorted by specificity.
+    rules: Vec<CompiledRule>,
+    index: RuleIndex,
+}
+
+#[derive(Clone, Debug)]
+struct CompiledRule {
+    selector: CompiledSelector,
+    specificity: [u8; 3],
+    declarations: Vec<CompiledDeclaration>,
+}
+
+#[derive(Clone, Debug)]
+struct CompiledDeclaration {
+    name: String,
+    value: String,
+    important: bool,
+}
+
+impl CompiledStyleSheet {
+    /// Parses a CSS stylesheet.
+    ///
+    /// Unsupported rules are skipped.
+    pub fn parse(text: &str) -> Self {
+        let sheet = simplecss::StyleSheet::parse(text);
+
+        let mut rules = Vec::with_capacity(sheet.rules.len());
+        let mut index = RuleIndex::default();
+        for rule in &sheet.rules {
+            let selector = match CompiledSelector::new(&rule.selector) {
+                Some(v) => v,
+                None => continue,
+            };
+
+            index.push(RuleKey::new(&rule.selector), rules.len());
+            rules.push(CompiledRule {
+                selector,
+                specificity: rule.selector.specificity(),
+                declarations: rule
+                    .declarations
+                    .iter()
+                    .map(|d| CompiledDeclaration {
+                        name: d.name.to_string(),
+                        value: d.value.to_string(),
+                        important: d.important,
+                    })
+                    .collect(),
+            });
+        }
+
+        CompiledStyleSheet { rules, index }
+    }
+}
+
+/// An owned copy of `simplecss::Selector`.
+///
+/// `simplecss::Selector` borrows its text, so it cannot be stored
+/// next to it in a `CompiledStyleSheet`.
+#[derive(Clone, Debug)]
+struct CompiledSelector {
+    components: Vec<CompiledComponent>,
+}
+
+#[derive(Clone, Debug)]
+struct CompiledComponent {
+    /// A combinator that precedes this component.
+    combinator: Combinator,
+    tag: Option<String>,
+    selectors: Vec<CompiledSubSelector>,
+}
+
+#[derive(Clone, Copy, PartialEq, Debug)]
+enum Combinator {
+    None,
+    Descendant,
+    Child,
+    AdjacentSibling,
+}
+
+#[derive(Clone, Debug)]
+enum CompiledSubSelector {
+    Attribute(String, CompiledAttributeOperator),
+    PseudoClass(simplecss::PseudoClass<'static>),
+    Lang(String),
+}
+
+#[derive(Clone, Debug)]
+enum CompiledAttributeOperator {
+    Exists,
+    Matches(String),
+    Contains(String),
+    StartsWith(String),
+}
+
+impl CompiledSelector {
+    fn new(selector: &simplecss::Selector) -> Option<Self> {
+        use simplecss::{AttributeOperator, PseudoClass, SelectorToken};
+
+        // Selectors do not expose their components, so tokenize them again.
+        let text = selector.to_string();
+
+        let mut components: Vec<CompiledComponent> = Vec::new();
+        let mut combinator = Some(Combinator::None);
+        for token in simplecss::SelectorTokenizer::from(text.as_str()) {
+            let sub = match token.ok()? {
+                SelectorToken::UniversalSelector => {
+                    components.push(CompiledComponent {
+                        combinator: combinator.take().unwrap_or(Combinator::None),
+                        tag: None,
+                        selectors: Vec::new(),
+                    });
+                    continue;
+                }
+                SelectorToken::TypeSelector(name) => {
+                    components.push(CompiledComponent {
+                        combinator: combinator.take().unwrap_or(Combinator::None),
+                        tag: Some(name.to_string()),
+                        selectors: Vec::new(),
+                    });
+                    continue;
+                }
+                SelectorToken::DescendantCombinator => {
+                    combinator = Some(Combinator::Descendant);
+                    continue;
+                }
+                SelectorToken::ChildCombinator => {
+                    combinator = Some(Combinator::Child);
+                    continue;
+                }
+                SelectorToken::AdjacentCombinator => {
+                    combinator = Some(Combinator::AdjacentSibling);
+                    continue;
+                }
+                SelectorToken::ClassSelector(name) => CompiledSubSelector::Attribute(
+                    "class".to_string(),
+                    CompiledAttributeOperator::Contains(name.to_string()),
+                ),
+                SelectorToken::IdSelector(name) => CompiledSubSelector::Attribute(
+                    "id".to_string(),
+                    CompiledAttributeOperator::Matches(name.to_string()),
+                ),
+                SelectorToken::AttributeSelector(name, operator) => {
+                    let operator = match operator {
+                        AttributeOperator::Exists => CompiledAttributeOperator::Exists,
+                        AttributeOperator::Matches(v) => {
+                            CompiledAttributeOperator::Matches(v.to_string())
+                        }
+                        AttributeOperator::Contains(v) => {
+                            CompiledAttributeOperator::Contains(v.to_string())
+                        }
+                        AttributeOperator::StartsWith(v) => {
+                            CompiledAttributeOperator::StartsWith(v.to_string())
+                        }
+                    };
+
+                    CompiledSubSelector::Attribute(name.to_string(), operator)
+                }
+                SelectorToken::PseudoClass(name) => {
+                    let class = match name {
+                        "first-child" => PseudoClass::FirstChild,
+                        "link" => PseudoClass::Link,
+                        "visited" => PseudoClass::Visited,
+                        "hover" => PseudoClass::Hover,
+                        "active" => PseudoClass::Active,
+                        "focus" => PseudoClass::Focus,
+                        _ => return None,
+                    };
+
+                    CompiledSubSelector::PseudoClass(class)
+                }
+                SelectorToken::LangPseudoClass(lang) => CompiledSubSelector::Lang(lang.to_string()),
+            };
+
+            // Sub-selectors without a type selector start an universal compound selector.
+            if let Some(combinator) = combinator.take() {
+                components.push(CompiledComponent {
+                    combinator,
+                    tag: None,
+                    selectors: Vec::new(),
+                });
+            }
+
+            components.last_mut()?.selectors.push(sub);
+        }
+
+        if components.is_empty() {
+            return None;
+        }
+
+        Some(CompiledSelector { components })
+    }
+
+    /// Mirrors `simplecss::Selector::matches`.
+    fn matches<E: simplecss::Element>(&self, element: &E) -> bool {
+        self.match_component(self.components.len() - 1, element)
+    }
+
+    fn match_component<E: simplecss::Element>(&self, idx: usize, element: &E) -> bool {
+        use simplecss::{AttributeOperator, PseudoClass};
+
+        let component = &self.components[idx];
+
+        if let Some(ref tag) = component.tag {
+            if !element.has_local_name(tag) {
+                return false;
+            }
+        }
+
+        for sub in &component.selectors {
+            let is_match = match sub {
+                CompiledSubSelector::Attribute(name, operator) => {
+                    let operator = match operator {
+                        CompiledAttributeOperator::Exists => AttributeOperator::Exists,
+                        CompiledAttributeOperator::Matches(v) => AttributeOperator::Matches(v),
+                        CompiledAttributeOperator::Contains(v) => AttributeOperator::Contains(v),
+                        CompiledAttributeOperator::StartsWith(v) => {
+                            AttributeOperator::StartsWith(v)
+                        }
+                    };
+
+                    element.attribute_matches(name, operator)
+                }
+                CompiledSubSelector::PseudoClass(class) => element.pseudo_class_matches(*class),
+                CompiledSubSelector::Lang(lang) => {
+                    element.pseudo_class_matches(PseudoClass::Lang(lang))
+                }
+            };
+
+            if !is_match {
+                return false;
+            }
+        }
+
+        match component.combinator {
+            Combinator::None => true,
+            Combinator::Descendant => {
+                let mut parent = element.parent_element();
+                while let Some(e) = parent {
+                    if self.match_component(idx - 1, &e) {
+                        return true;
+                    }
+
+                    parent = e.parent_element();
+                }
+
+                false
+            }
+            Combinator::Child => match element.parent_element() {
+                Some(e) => self.match_component(idx - 1, &e),
+                None => false,
+            },
+            Combinator::AdjacentSibling => match element.prev_sibling_element() {
+                Some(e) => self.match_component(idx - 1, &e),
+                None => false,
+            },
+        }
+    }
+}
+
+/// Document CSS rules, preceded by the ones of an injected compiled stylesheet.
+///
+/// Rules of both are indexed by their key selector.
+/// A key selector is the rightmost compound selector, like `.b` in `.a > .b`.
+/// An element can be matched only by rules which key ID, class or tag name it has,
+/// so only those rules have to be tested, instead of all of them.
+pub(crate) struct StyleSheet<'a> {
+    compiled: Option<&'a CompiledStyleSheet>,
+    /// Sorted by specificity.
+    rules: Vec<StyleRule<'a>>,
+    index: RuleIndex,
+}
+
+struct StyleRule<'a> {
+    selector: simplecss::Selector<'a>,
+    specificity: [u8; 3],
+    declarations: Vec<Declaration<'a>>,
+    key: RuleKey,
+}
+
+#[derive(Clone, Debug)]
+enum RuleKey {
+    Id(String),
+    Class(String),
+    Tag(String),
+    Universal,
+}
+
+impl RuleKey {
+    /// Picks the most selective part of a key selector.
+    fn new(selector: &simplecss::Selector) -> Self {
+        use simplecss::{AttributeOperator, SelectorToken};
+
+        // Selectors do not expose their components, so tokenize them again.
+        // IDs and classes can be represented as attribute selectors as well.
+        let text = selector.to_string();
+
+        let mut id = None;
+        let mut class = None;
+        let mut tag = None;
+        for token in simplecss::SelectorTokenizer::from(text.as_str()) {
+            match token {
+                Ok(SelectorToken::IdSelector(name))
+                | Ok(SelectorToken::AttributeSelector("id", AttributeOperator::Matches(name))) => {
+                    id = Some(name)
+                }
+                Ok(SelectorToken::ClassSelector(name))
+                | Ok(SelectorToken::AttributeSelector(
+                    "class",
+                    AttributeOperator::Contains(name),
+                )) => class = class.or(Some(name)),
+                Ok(SelectorToken::TypeSelector(name)) => tag = Some(name),
+                Ok(SelectorToken::DescendantCombinator)
+                | Ok(SelectorToken::ChildCombinator)
+                | Ok(SelectorToken::AdjacentCombinator) => {
+                    // Only the rightmost compound selector is a key one.
+                    id = None;
+                    class = None;
+                    tag = None;
+                }
+                Ok(_) => {}
+                // Should not happen, since the selector was already parsed,
+                // but such rule would simply be tested against all elements.
+                Err(_) => return RuleKey::Universal,
+            }
+        }
+
+        if let Some(id) = id {
+            RuleKey::Id(id.to_string())
+        } else if let Some(class) = class {
+            RuleKey::Class(class.to_string())
+        } else if let Some(tag) = tag {
+            RuleKey::Tag(tag.to_string())
+        } else {
+            RuleKey::Universal
+        }
+    }
+}
+
+/// Rule indices grouped by their key.
+#[derive(Clone, Default, Debug)]
+struct RuleIndex {
+    by_id: HashMap<String, Vec<usize>>,
+    by_class: HashMap<String, Vec<usize>>,
+    by_tag: HashMap<String, Vec<usize>>,
+    universal: Vec<usize>,
+}
+
+impl RuleIndex {
+    fn push(&mut self, key: RuleKey, idx: usize) {
+        match key {
+            RuleKey::Id(id) => self.by_id.entry(id).or_default().push(idx),
+            RuleKey::Class(class) => self.by_class.entry(class).or_default().push(idx),
+            RuleKey::Tag(tag) => self.by_tag.entry(tag).or_default().push(idx),
+            RuleKey::Universal => self.universal.push(idx),
+        }
+    }
+
+    /// Returns indices of rules that may match an element, in ascending order.
+    fn candidates(&self, node: roxmltree::Node) -> Vec<usize> {
+        let mut candidates = self.universal.clone();
+
+        if let Some(ids) = node.attribute("id").and_then(|id| self.by_id.get(id)) {
+            candidates.extend_from_slice(ids);
+        }
+
+        if let Some(classes) = node.attribute("class") {
+            for class in classes.split_whitespace() {
+                if let Some(rules) = self.by_class.get(class) {
+                    candidates.extend_from_slice(rules);
+                }
+            }
+        }
+
+        if let Some(rules) = self.by_tag.get(node.tag_name().name()) {
+            candidates.extend_from_slice(rules);
+        }
+
+        // Rules must be applied in the stylesheet order.
+        // An element can also have the same class multiple times.
+        candidates.sort_unstable();
+        candidates.dedup();
+        candidates
+    }
+}
+
+impl<'a> StyleSheet<'a> {
+    fn new(compiled: Option<&'a CompiledStyleSheet>, mut rules: Vec<StyleRule<'a>>) -> Self {
+        let mut index = RuleIndex::default();
+        for (idx, rule) in rules.iter_mut().enumerate() {
+            index.push(std::mem::replace(&mut rule.key, RuleKey::Universal), idx);
+        }
+
+        StyleSheet {
+            compiled,
+            rules,
+            index,
+        }
+    }
+
+    /// Returns declarations of rules that match an element, in the stylesheet order.
+    ///
+    /// Injected compiled rules do not override document ones with the same specificity
+    /// (we mimic the logic of rsvg-convert), so they are applied first.
+    fn matching_rules(&self, node: roxmltree::Node) -> Vec<Declaration<'_>> {
+        let xml_node = XmlNode(node);
+
+        let mut compiled = Vec::new();
+        if let Some(sheet) = self.compiled {
+            compiled = sheet
+                .index
+                .candidates(node)
+                .into_iter()
+                .map(|idx| &sheet.rules[idx])
+                .filter(|rule| rule.selector.matches(&xml_node))
+                .collect();
+        }
+
+        let document: Vec<&StyleRule> = self
+            .index
+            .candidates(node)
+            .into_iter()
+            .map(|idx| &self.rules[idx])
+            .filter(|rule| rule.selector.matches(&xml_node))
+            .collect();
+
+        // Both lists are sorted by specificity, so simply merge them.
+        let mut declarations = Vec::new();
+        let mut compiled = compiled.into_iter().peekable();
+        let mut document = document.into_iter().peekable();
+        loop {
+            let is_compiled = match (compiled.peek(), document.peek()) {
+                (Some(a), Some(b)) => a.specificity <= b.specificity,
+                (Some(_), None) => true,
+                (None, Some(_)) => false,
+                (None, None) => break,
+            };
+
+            if is_compiled {
+                if let Some(rule) = compiled.next() {
+                    declarations.extend(rule.declarations.iter().map(|d| Declaration {
+                        name: &d.name,
+                        value: &d.value,
+                        important: d.important,
+                    }));
+                }
+            } else if let Some(rule) = document.next() {
+                declarations.extend_from_slice(&rule.declarations);
+            }
+        }
+
+        declarations
+    }
 }
 
 struct XmlNode<'a, 'input: 'a>(roxmltree::Node<'a, 'input>);
@@ -686,11 +1271,13 @@ fn fix_recursive_patterns(doc: &mut Document) {
     while let Some(node_id) = find_recursive_pattern(AId::Fill, doc) {
         let idx = doc.get(node_id).attribute_id(AId::Fill).unwrap();
         doc.attrs[idx].value = roxmltree::StringStorage::Borrowed("none");
+        doc.attrs[idx].parsed = ParsedValue::None;
     }
 
     while let Some(node_id) = find_recursive_pattern(AId::Stroke, doc) {
         let idx = doc.get(node_id).attribute_id(AId::Stroke).unwrap();
         doc.attrs[idx].value = roxmltree::StringStorage::Borrowed("none");
+        doc.attrs[idx].parsed = ParsedValue::None;
     }
 }
 
@@ -742,6 +1329,7 @@ fn fix_recursive_links(eid: EId, aid: AId, doc: &mut Document) {
     while let Some(node_id) = find_recursive_link(eid, aid, doc) {
         let idx = doc.get(node_id).attribute_id(aid).unwrap();
         doc.attrs[idx].value = roxmltree::StringStorage::Borrowed("none");
+        doc.attrs[idx].parsed = ParsedValue::None;
     }
 }
 
@@ -807,5 +1395,6 @@ fn fix_recursive_fe_image(doc: &mut Document) {
     for id in ids {
         let idx = doc.get(id).attribute_id(AId::Filter).unwrap();
         doc.attrs[idx].value = roxmltree::StringStorage::Borrowed("none");
+        doc.attrs[idx].parsed = ParsedValue::None;
     }
 }
@@ -3,17 +3,20 @@
 
 #![allow(clippy::comparison_chain)]
 
-use roxmltree::Error;
-
+use super::parse::StyleSheet;
 use super::{AId, Document, EId, NodeId, NodeKind, SvgNode};
+use crate::parser::limits::Budget;
+use crate::Error;
 
 const XLINK_NS: &str = "http://www.w3.org/1999/xlink";
 
 pub(crate) fn parse_svg_text_element<'input>(
     parent: roxmltree::Node<'_, 'input>,
     parent_id: NodeId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
+    depth: u32,
     doc: &mut Document<'input>,
+    budget: &mut Budget,
 ) -> Result<(), Error> {
     debug_assert_eq!(parent.tag_name().name(), "text");
 
@@ -31,7 +34,7 @@ pub(crate) fn parse_svg_text_element<'input>(
         }
     };
 
-    parse_svg_text_element_impl(parent, parent_id, style_sheet, space, doc)?;
+    parse_svg_text_element_impl(parent, parent_id, style_sheet, space, depth, doc, budget)?;
 
     trim_text_nodes(parent_id, space, doc);
     Ok(())
@@ -40,10 +43,16 @@ pub(crate) fn parse_svg_text_element<'input>(
 fn parse_svg_text_element_impl<'input>(
     parent: roxmltree::Node<'_, 'input>,
     parent_id: NodeId,
-    style_sheet: &simplecss::StyleSheet,
+    style_sheet: &StyleSheet,
     space: XmlSpace,
+    depth: u32,
     doc: &mut Document<'input>,
+    budget: &mut Budget,
 ) -> Result<(), Error> {
+    if depth > budget.limits().max_depth {
+        return Err(Error::DepthLimitReached);
+    }
+
     for node in parent.children() {
         if node.is_text() {
             let text = trim_text(node.text().unwrap(), space);
@@ -77,8 +86,15 @@ fn parse_svg_text_element_impl<'input>(
             is_tref = true;
         }
 
-        let node_id =
-            super::parse::parse_svg_element(node, parent_id, tag_name, style_sheet, false, doc)?;
+        let node_id = super::parse::parse_svg_element(
+            node,
+            parent_id,
+            tag_name,
+            style_sheet,
+            false,
+            doc,
+            budget,
+        )?;
         let space = get_xmlspace(doc, node_id, space);
 
         if is_tref {
@@ -93,7 +109,7 @@ fn parse_svg_text_element_impl<'input>(
                 }
             }
         } else {
-            parse_svg_text_element_impl(node, node_id, style_sheet, space, doc)?;
+            parse_svg_text_element_impl(node, node_id, style_sheet, space, depth + 1, doc, budget)?;
         }
     }
 
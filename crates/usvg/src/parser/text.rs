@@ -136,11 +136,19 @@ pub(crate) fn convert(
         abs_bounding_box: dummy,
         stroke_bounding_box: dummy,
         abs_stroke_bounding_box: dummy,
-        flattened: Box::new(Group::empty()),
+        flattened: Default::default(),
         layouted: vec![],
+        fontdb: None,
     };
 
-    if text::convert(&mut text, &state.opt.font_resolver, &mut cache.fontdb).is_none() {
+    if text::convert(
+        &mut text,
+        &state.opt.font_resolver,
+        &mut cache.fontdb,
+        state.opt.lazy_text,
+    )
+    .is_none()
+    {
         return;
     }
 
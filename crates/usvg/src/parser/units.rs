@@ -93,10 +93,25 @@ fn convert_percent(length: Length, base: f32) -> f32 {
 
 #[inline(never)]
 pub(crate) fn resolve_font_size(node: SvgNode, state: &converter::State) -> f32 {
-    let nodes: Vec<_> = node.ancestors().collect();
+    // Only relative font sizes depend on the parent one,
+    // so there is no need to look past the closest absolute one.
+    let mut nodes = Vec::new();
+    for n in node.ancestors() {
+        if !n.has_attribute(AId::FontSize) {
+            continue;
+        }
+
+        nodes.push(n);
+
+        if let Some(length) = n.try_attribute::<Length>(AId::FontSize) {
+            if !matches!(length.unit, Unit::Em | Unit::Ex | Unit::Percent) {
+                break;
+            }
+        }
+    }
+
     let mut font_size = state.opt.font_size;
-    for n in nodes.iter().rev().skip(1) {
-        // skip Root
+    for n in nodes.iter().rev() {
         if let Some(length) = n.try_attribute::<Length>(AId::FontSize) {
             let dpi = state.opt.dpi;
             let n = length.number as f32;
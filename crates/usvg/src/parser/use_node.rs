@@ -5,10 +5,151 @@ use std::sync::Arc;
 
 use svgtypes::{Length, LengthUnit};
 
-use super::svgtree::{AId, EId, SvgNode};
+use super::svgtree::{AId, Attribute, EId, SvgNode};
 use super::{converter, style};
 use crate::tree::ContextElement;
-use crate::{Group, IsValidLength, Node, NonZeroRect, Path, Size, Transform, ViewBox};
+use crate::{Group, Instance, IsValidLength, Node, NonZeroRect, Path, Size, Transform, ViewBox};
+
+/// Everything the conversion of `use` content depends on.
+///
+/// `use` elements with the same key produce identical subtrees,
+/// which are converted only once.
+#[derive(PartialEq, Eq, Hash)]
+pub(crate) struct InstanceKey {
+    view_box: [u32; 4],
+    use_size: (Option<u32>, Option<u32>),
+    /// Inherited attributes, followed by the content elements and their attributes.
+    items: Vec<KeyItem>,
+}
+
+#[derive(PartialEq, Eq, Hash)]
+enum KeyItem {
+    Start(u16),
+    End,
+    Attribute(u16, String),
+}
+
+impl InstanceKey {
+    /// Returns `None` when the content depends on where it is placed.
+    fn new(node: SvgNode, state: &converter::State) -> Option<Self> {
+        let mut items = Vec::new();
+
+        for ancestor in node.ancestors() {
+            for attr in ancestor.attributes() {
+                if attr.name.is_inheritable() {
+                    push_attribute(ancestor, attr, &mut items)?;
+                }
+            }
+        }
+
+        for child in node.children() {
+            push_element(child, &mut items)?;
+        }
+
+        let vb = state.view_box;
+        Some(InstanceKey {
+            view_box: [
+                vb.x().to_bits(),
+                vb.y().to_bits(),
+                vb.width().to_bits(),
+                vb.height().to_bits(),
+            ],
+            use_size: (
+                state.use_size.0.map(f32::to_bits),
+                state.use_size.1.map(f32::to_bits),
+            ),
+            items,
+        })
+    }
+}
+
+fn push_element(node: SvgNode, items: &mut Vec<KeyItem>) -> Option<()> {
+    // Text layout depends on the canvas scale.
+    let tag = node.tag_name().filter(|tag| *tag != EId::Text)?;
+
+    items.push(KeyItem::Start(tag as u16));
+    for attr in node.attributes() {
+        push_attribute(node, attr, items)?;
+    }
+
+    for child in node.children() {
+        push_element(child, items)?;
+    }
+
+    items.push(KeyItem::End);
+    Some(())
+}
+
+fn push_attribute(node: SvgNode, attr: &Attribute, items: &mut Vec<KeyItem>) -> Option<()> {
+    let is_shareable = match attr.name {
+        // Masks, filters and patterns are updated in place after the whole tree is converted,
+        // which cannot be done for a shared subtree.
+        AId::Mask | AId::Filter => attr.value.as_str() == "none",
+        AId::Fill | AId::Stroke => match node.attribute::<svgtypes::Paint>(attr.name) {
+            Some(svgtypes::Paint::ContextFill | svgtypes::Paint::ContextStroke) => false,
+            Some(svgtypes::Paint::FuncIRI(link, _)) => {
+                let link = node.document().element_by_id(link);
+                link.and_then(|n| n.tag_name()) != Some(EId::Pattern)
+            }
+            _ => true,
+        },
+        // Marker content is not a part of the key.
+        AId::MarkerStart | AId::MarkerMid | AId::MarkerEnd => attr.value.as_str() == "none",
+        _ => true,
+    };
+
+    if !is_shareable {
+        return None;
+    }
+
+    items.push(KeyItem::Attribute(
+        attr.name as u16,
+        attr.value.as_str().to_string(),
+    ));
+    Some(())
+}
+
+/// Converts `node` children once for all `use` elements with the same content.
+///
+/// Paint servers of the subtree are resolved right away,
+/// since the tree post-processing doesn't visit shared subtrees.
+///
+/// Returns `None` when the content has to be converted for each `use` separately.
+fn convert_shared(
+    node: SvgNode,
+    state: &converter::State,
+    cache: &mut converter::Cache,
+) -> Option<Arc<Group>> {
+    let use_node = match node.tag_name() {
+        Some(EId::Use) => node,
+        Some(EId::Symbol) => node.parent_element()?,
+        _ => return None,
+    };
+
+    if state.parent_clip_path.is_some() || !state.parent_markers.is_empty() || state.fe_image_link {
+        return None;
+    }
+
+    // Nothing to share.
+    let link = use_node.attribute::<SvgNode>(AId::Href)?;
+    if !cache.has_multiple_uses(link.element_id()) {
+        return None;
+    }
+
+    let key = InstanceKey::new(node, state)?;
+    if let Some(root) = cache.instances.get(&key) {
+        return Some(root.clone());
+    }
+
+    let mut root = Group::empty();
+    converter::convert_children(node, state, cache, &mut root);
+    super::paint_server::update_paint_servers(&mut root, Transform::default(), None, None, cache);
+    root.calculate_bounding_boxes();
+
+    let root = Arc::new(root);
+    cache.instances.insert(key, root.clone());
+    Some(root)
+}
 
 pub(crate) fn convert(
     node: SvgNode,
@@ -278,6 +419,11 @@ fn convert_children(
         converter::convert_group(node, state, required, cache, parent, &|cache, g| {
             if state.parent_clip_path.is_some() {
                 converter::convert_clip_path_elements(node, state, cache, g);
+            } else if let Some(root) = convert_shared(node, state, cache) {
+                if root.has_children() {
+                    let instance = Instance::new(root, g.abs_transform);
+                    g.children.push(Node::Instance(Box::new(instance)));
+                }
             } else {
                 converter::convert_children(node, state, cache, g);
             }
@@ -4,10 +4,13 @@
 use std::sync::Arc;
 
 use fontdb::{Database, ID};
+use rustybuzz::ttf_parser;
 use svgtypes::FontFamily;
+use tiny_skia_path::NonZeroRect;
 
 use self::layout::DatabaseExt;
-use crate::{Font, FontStretch, FontStyle, Text};
+use crate::tree::BBox;
+use crate::{Font, FontStretch, FontStyle, LineJoin, Rect, Text};
 
 mod flatten;
 
@@ -201,20 +204,99 @@ impl std::fmt::Debug for FontResolver<'_> {
 ///    is not based on the outlines of a glyph, but instead the glyph metrics as well
 ///    as decoration spans).
 /// 2. We convert all of the positioned glyphs into outlines.
+///
+/// When `lazy` is set, the second step is deferred until [`Text::flattened`] is called
+/// and the stroke bbox is estimated instead.
 pub(crate) fn convert(
     text: &mut Text,
     resolver: &FontResolver,
     fontdb: &mut Arc<fontdb::Database>,
+    lazy: bool,
 ) -> Option<()> {
     let (text_fragments, bbox) = layout::layout_text(text, resolver, fontdb)?;
     text.layouted = text_fragments;
     text.bounding_box = bbox.to_rect();
     text.abs_bounding_box = bbox.transform(text.abs_transform)?.to_rect();
 
-    let (group, stroke_bbox) = flatten::flatten(text, fontdb)?;
-    text.flattened = Box::new(group);
+    let stroke_bbox = if lazy {
+        text.fontdb = Some(fontdb.clone());
+        estimate_stroke_bbox(text, bbox, fontdb)?
+    } else {
+        let (group, stroke_bbox) = flatten::flatten(text, fontdb)?;
+        text.flattened = Box::new(group).into();
+        stroke_bbox
+    };
+
     text.stroke_bounding_box = stroke_bbox.to_rect();
     text.abs_stroke_bounding_box = stroke_bbox.transform(text.abs_transform)?.to_rect();
 
     Some(())
 }
+
+/// Converts an already layouted text into paths.
+pub(crate) fn flatten(text: &Text, fontdb: &fontdb::Database) -> Option<crate::Group> {
+    flatten::flatten(text, fontdb).map(|(group, _)| group)
+}
+
+/// Estimates a text stroke bbox without outlining the glyphs.
+///
+/// Uses glyph bounding boxes from the font and approximates strokes,
+/// so the result is usually slightly larger than the flattened text one.
+fn estimate_stroke_bbox(
+    text: &Text,
+    bbox: NonZeroRect,
+    fontdb: &fontdb::Database,
+) -> Option<NonZeroRect> {
+    let mut stroke_bbox = BBox::from(bbox);
+    for span in &text.layouted {
+        let mut span_bbox = BBox::default();
+        for glyph in &span.positioned_glyphs {
+            let glyph_bbox = fontdb
+                .with_face_data(glyph.font, |data, face_index| {
+                    let font = ttf_parser::Face::parse(data, face_index).ok()?;
+                    font.glyph_bounding_box(glyph.id)
+                })
+                .flatten()
+                .and_then(|r| {
+                    Rect::from_ltrb(
+                        r.x_min as f32,
+                        r.y_min as f32,
+                        r.x_max as f32,
+                        r.y_max as f32,
+                    )
+                })
+                .and_then(|r| r.transform(glyph.outline_transform()));
+
+            if let Some(r) = glyph_bbox {
+                span_bbox = span_bbox.expand(r);
+            }
+        }
+
+        if let (Some(stroke), Some(r)) = (span.stroke.as_ref(), span_bbox.to_rect()) {
+            // Enough for square caps and joins within the miter limit.
+            let scale = match stroke.linejoin {
+                LineJoin::Miter | LineJoin::MiterClip => {
+                    stroke.miterlimit.get().max(std::f32::consts::SQRT_2)
+                }
+                LineJoin::Round | LineJoin::Bevel => std::f32::consts::SQRT_2,
+            };
+            let w = stroke.width.get() / 2.0 * scale;
+            if let Some(r) =
+                Rect::from_ltrb(r.left() - w, r.top() - w, r.right() + w, r.bottom() + w)
+            {
+                span_bbox = span_bbox.expand(r);
+            }
+        }
+
+        stroke_bbox = stroke_bbox.expand(span_bbox);
+
+        for path in [&span.overline, &span.underline, &span.line_through]
+            .into_iter()
+            .flatten()
+        {
+            stroke_bbox = stroke_bbox.expand(path.stroke_bounding_box());
+        }
+    }
+
+    stroke_bbox.to_non_zero_rect()
+}
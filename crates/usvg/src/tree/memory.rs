@@ -0,0 +1,273 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use std::collections::HashSet;
+use std::mem::size_of;
+use std::sync::Arc;
+
+use super::*;
+
+/// Size of the `Arc` reference counters.
+const ARC_HEADER: usize = 2 * size_of::<usize>();
+
+/// Estimates heap memory used by a tree.
+///
+/// Data shared via `Arc` is accounted only once.
+#[derive(Default)]
+pub(crate) struct MemoryCounter {
+    seen: HashSet<usize>,
+}
+
+impl MemoryCounter {
+    /// Returns `true` when an `Arc` data is visited for the first time.
+    fn first_visit<T>(&mut self, arc: &Arc<T>) -> bool {
+        self.seen.insert(Arc::as_ptr(arc) as *const () as usize)
+    }
+
+    pub(crate) fn tree(&mut self, tree: &Tree) -> usize {
+        let mut size = self.group(&tree.root);
+
+        size += vec_size(&tree.linear_gradients);
+        size += vec_size(&tree.radial_gradients);
+        size += vec_size(&tree.patterns);
+        size += vec_size(&tree.clip_paths);
+        size += vec_size(&tree.masks);
+        size += vec_size(&tree.filters);
+
+        // All of them are referenced by nodes as well, so this is usually a no-op.
+        for lg in &tree.linear_gradients {
+            size += self.linear_gradient(lg);
+        }
+        for rg in &tree.radial_gradients {
+            size += self.radial_gradient(rg);
+        }
+        for patt in &tree.patterns {
+            size += self.pattern(patt);
+        }
+        for clip_path in &tree.clip_paths {
+            size += self.clip_path(clip_path);
+        }
+        for mask in &tree.masks {
+            size += self.mask(mask);
+        }
+        for filter in &tree.filters {
+            size += self.filter(filter);
+        }
+
+        size
+    }
+
+    fn group(&mut self, group: &Group) -> usize {
+        let mut size = group.id.capacity();
+
+        if let Some(ref clip_path) = group.clip_path {
+            size += self.clip_path(clip_path);
+        }
+
+        if let Some(ref mask) = group.mask {
+            size += self.mask(mask);
+        }
+
+        size += vec_size(&group.filters);
+        for filter in &group.filters {
+            size += self.filter(filter);
+        }
+
+        size += vec_size(&group.children);
+        for node in &group.children {
+            size += self.node(node);
+        }
+
+        if let Some(index) = group.spatial_index.get() {
+            size += size_of::<spatial::SpatialIndex>() + index.memory_usage();
+        }
+
+        size
+    }
+
+    fn node(&mut self, node: &Node) -> usize {
+        match node {
+            Node::Group(ref group) => size_of::<Group>() + self.group(group),
+            Node::Path(ref path) => size_of::<Path>() + self.path(path),
+            Node::Image(ref image) => size_of::<Image>() + self.image(image),
+            Node::Text(ref text) => size_of::<Text>() + self.text(text),
+            Node::Instance(ref instance) => size_of::<Instance>() + self.instance(instance),
+        }
+    }
+
+    fn instance(&mut self, instance: &Instance) -> usize {
+        if !self.first_visit(&instance.root) {
+            return 0;
+        }
+
+        ARC_HEADER + size_of::<Group>() + self.group(&instance.root)
+    }
+
+    fn path(&mut self, path: &Path) -> usize {
+        let mut size = path.id.capacity();
+
+        if let Some(ref fill) = path.fill {
+            size += self.paint(&fill.paint);
+        }
+
+        if let Some(ref stroke) = path.stroke {
+            size += self.stroke(stroke);
+        }
+
+        size + self.path_data(&path.data)
+    }
+
+    fn path_data(&mut self, data: &Arc<tiny_skia_path::Path>) -> usize {
+        if !self.first_visit(data) {
+            return 0;
+        }
+
+        ARC_HEADER
+            + size_of::<tiny_skia_path::Path>()
+            + data.verbs().len() * size_of::<tiny_skia_path::PathVerb>()
+            + data.points().len() * size_of::<tiny_skia_path::Point>()
+    }
+
+    fn stroke(&mut self, stroke: &Stroke) -> usize {
+        let dasharray = stroke.dasharray.as_ref().map(vec_size).unwrap_or(0);
+        dasharray + self.paint(&stroke.paint)
+    }
+
+    fn paint(&mut self, paint: &Paint) -> usize {
+        match paint {
+            Paint::Color(_) => 0,
+            Paint::LinearGradient(ref lg) => self.linear_gradient(lg),
+            Paint::RadialGradient(ref rg) => self.radial_gradient(rg),
+            Paint::Pattern(ref patt) => self.pattern(patt),
+        }
+    }
+
+    fn linear_gradient(&mut self, lg: &Arc<LinearGradient>) -> usize {
+        if !self.first_visit(lg) {
+            return 0;
+        }
+
+        ARC_HEADER + size_of::<LinearGradient>() + lg.base.id.get().len() + vec_size(&lg.base.stops)
+    }
+
+    fn radial_gradient(&mut self, rg: &Arc<RadialGradient>) -> usize {
+        if !self.first_visit(rg) {
+            return 0;
+        }
+
+        ARC_HEADER + size_of::<RadialGradient>() + rg.base.id.get().len() + vec_size(&rg.base.stops)
+    }
+
+    fn pattern(&mut self, patt: &Arc<Pattern>) -> usize {
+        if !self.first_visit(patt) {
+            return 0;
+        }
+
+        ARC_HEADER + size_of::<Pattern>() + patt.id.get().len() + self.group(&patt.root)
+    }
+
+    fn clip_path(&mut self, clip_path: &Arc<ClipPath>) -> usize {
+        if !self.first_visit(clip_path) {
+            return 0;
+        }
+
+        let mut size = ARC_HEADER + size_of::<ClipPath>() + clip_path.id.get().len();
+        if let Some(ref clip_path) = clip_path.clip_path {
+            size += self.clip_path(clip_path);
+        }
+
+        size + self.group(&clip_path.root)
+    }
+
+    fn mask(&mut self, mask: &Arc<Mask>) -> usize {
+        if !self.first_visit(mask) {
+            return 0;
+        }
+
+        let mut size = ARC_HEADER + size_of::<Mask>() + mask.id.get().len();
+        if let Some(ref mask) = mask.mask {
+            size += self.mask(mask);
+        }
+
+        size + self.group(&mask.root)
+    }
+
+    fn filter(&mut self, filter: &Arc<filter::Filter>) -> usize {
+        if !self.first_visit(filter) {
+            return 0;
+        }
+
+        let mut size = ARC_HEADER
+            + size_of::<filter::Filter>()
+            + filter.id.get().len()
+            + vec_size(&filter.primitives);
+
+        for primitive in &filter.primitives {
+            size += primitive.result.capacity();
+            size += match primitive.kind {
+                filter::Kind::ConvolveMatrix(ref fe) => vec_size(&fe.matrix.data),
+                filter::Kind::Image(ref fe) => self.group(&fe.root),
+                filter::Kind::Merge(ref fe) => vec_size(&fe.inputs),
+                _ => 0,
+            };
+        }
+
+        size
+    }
+
+    fn image(&mut self, image: &Image) -> usize {
+        let size = image.id.capacity();
+        match image.kind {
+            ImageKind::JPEG(ref data)
+            | ImageKind::PNG(ref data)
+            | ImageKind::GIF(ref data)
+            | ImageKind::WEBP(ref data) => {
+                if !self.first_visit(data) {
+                    return size;
+                }
+
+                size + ARC_HEADER + size_of::<Vec<u8>>() + data.capacity()
+            }
+            ImageKind::SVG(ref tree) => {
+                if !self.first_visit(tree) {
+                    return size;
+                }
+
+                size + ARC_HEADER + size_of::<Tree>() + self.tree(tree)
+            }
+        }
+    }
+
+    fn text(&mut self, text: &Text) -> usize {
+        let mut size = text.id.capacity()
+            + vec_size(&text.dx)
+            + vec_size(&text.dy)
+            + vec_size(&text.rotate)
+            + vec_size(&text.chunks);
+
+        for chunk in &text.chunks {
+            size += chunk.text.capacity() + vec_size(&chunk.spans);
+            if let TextFlow::Path(ref text_path) = chunk.text_flow {
+                if self.first_visit(text_path) {
+                    size += ARC_HEADER + size_of::<TextPath>() + text_path.id.get().len();
+                    size += self.path_data(&text_path.path);
+                }
+            }
+        }
+
+        #[cfg(feature = "text")]
+        {
+            size += vec_size(&text.layouted);
+        }
+
+        if let Some(flattened) = text.flattened.get() {
+            size += size_of::<Group>() + self.group(flattened);
+        }
+
+        size
+    }
+}
+
+fn vec_size<T>(vec: &Vec<T>) -> usize {
+    vec.capacity() * size_of::<T>()
+}
@@ -3,10 +3,15 @@
 
 pub mod filter;
 mod geom;
+mod memory;
+mod optimize;
+mod query;
+mod spatial;
 mod text;
 
 use std::sync::Arc;
 
+use once_cell::sync::OnceCell;
 pub use strict_num::{self, ApproxEqUlps, NonZeroPositiveF32, NormalizedF32, PositiveF32};
 
 pub use tiny_skia_path;
@@ -868,6 +873,7 @@ pub enum Node {
     Path(Box<Path>),
     Image(Box<Image>),
     Text(Box<Text>),
+    Instance(Box<Instance>),
 }
 
 impl Node {
@@ -878,6 +884,7 @@ impl Node {
             Node::Path(ref e) => e.id.as_str(),
             Node::Image(ref e) => e.id.as_str(),
             Node::Text(ref e) => e.id.as_str(),
+            Node::Instance(_) => "",
         }
     }
 
@@ -890,6 +897,7 @@ impl Node {
             Node::Path(ref path) => path.abs_transform(),
             Node::Image(ref image) => image.abs_transform(),
             Node::Text(ref text) => text.abs_transform(),
+            Node::Instance(ref instance) => instance.abs_transform(),
         }
     }
 
@@ -900,6 +908,7 @@ impl Node {
             Node::Path(ref path) => path.bounding_box(),
             Node::Image(ref image) => image.bounding_box(),
             Node::Text(ref text) => text.bounding_box(),
+            Node::Instance(ref instance) => instance.bounding_box(),
         }
     }
 
@@ -910,6 +919,7 @@ impl Node {
             Node::Path(ref path) => path.abs_bounding_box(),
             Node::Image(ref image) => image.abs_bounding_box(),
             Node::Text(ref text) => text.abs_bounding_box(),
+            Node::Instance(ref instance) => instance.abs_bounding_box(),
         }
     }
 
@@ -921,6 +931,7 @@ impl Node {
             // Image cannot be stroked.
             Node::Image(ref image) => image.bounding_box(),
             Node::Text(ref text) => text.stroke_bounding_box(),
+            Node::Instance(ref instance) => instance.stroke_bounding_box(),
         }
     }
 
@@ -932,13 +943,14 @@ impl Node {
             // Image cannot be stroked.
             Node::Image(ref image) => image.abs_bounding_box(),
             Node::Text(ref text) => text.abs_stroke_bounding_box(),
+            Node::Instance(ref instance) => instance.abs_stroke_bounding_box(),
         }
     }
 
     /// Element's "layer" bounding box in canvas units, if any.
     ///
     /// For most nodes this is just `abs_bounding_box`,
-    /// but for groups this is `abs_layer_bounding_box`.
+    /// but for groups and instances this is `abs_layer_bounding_box`.
     ///
     /// See [`Group::layer_bounding_box`] for details.
     pub fn abs_layer_bounding_box(&self) -> Option<NonZeroRect> {
@@ -948,14 +960,15 @@ impl Node {
             Node::Path(ref path) => path.abs_bounding_box().to_non_zero_rect(),
             Node::Image(ref image) => image.abs_bounding_box().to_non_zero_rect(),
             Node::Text(ref text) => text.abs_bounding_box().to_non_zero_rect(),
+            Node::Instance(ref instance) => Some(instance.abs_layer_bounding_box()),
         }
     }
 
     /// Calls a closure for each subroot this `Node` has.
     ///
     /// The [`Tree::root`](Tree::root) field contain only render-able SVG elements.
-    /// But some elements, specifically clip paths, masks, patterns and feImage
-    /// can store their own SVG subtrees.
+    /// But some elements, specifically clip paths, masks, patterns, feImage
+    /// and instances can store their own SVG subtrees.
     /// And while one can access them manually, it's pretty verbose.
     /// This methods allows looping over _all_ SVG elements present in the `Tree`.
     ///
@@ -981,6 +994,7 @@ impl Node {
             Node::Path(ref path) => path.subroots(&mut f),
             Node::Image(ref image) => image.subroots(&mut f),
             Node::Text(ref text) => text.subroots(&mut f),
+            Node::Instance(ref instance) => instance.subroots(&mut f),
         }
     }
 }
@@ -1011,6 +1025,8 @@ pub struct Group {
     pub(crate) layer_bounding_box: NonZeroRect,
     pub(crate) abs_layer_bounding_box: NonZeroRect,
     pub(crate) children: Vec<Node>,
+    /// Built on the first [`Group::children_in_rect`] call.
+    pub(crate) spatial_index: OnceCell<Box<spatial::SpatialIndex>>,
 }
 
 impl Group {
@@ -1034,6 +1050,7 @@ impl Group {
             layer_bounding_box: NonZeroRect::from_xywh(0.0, 0.0, 1.0, 1.0).unwrap(),
             abs_layer_bounding_box: NonZeroRect::from_xywh(0.0, 0.0, 1.0, 1.0).unwrap(),
             children: Vec::new(),
+            spatial_index: OnceCell::new(),
         }
     }
 
@@ -1157,6 +1174,37 @@ impl Group {
         &self.children
     }
 
+    /// Calls a closure for each child whose layer bounding box intersects `rect`.
+    ///
+    /// `rect` is in the coordinates children are positioned in,
+    /// i.e. affected by the group transform.
+    /// Children are visited in paint order.
+    ///
+    /// For groups with many children, a spatial index is built on the first call,
+    /// so the following calls take time proportional to the number of matching children.
+    pub fn children_in_rect<'a, F: FnMut(&'a Node)>(&'a self, rect: Rect, mut f: F) {
+        if self.children.len() < spatial::MIN_INDEXED_CHILDREN {
+            for child in &self.children {
+                if spatial::intersects(spatial::layer_bounding_box(child), rect) {
+                    f(child);
+                }
+            }
+
+            return;
+        }
+
+        let index = self
+            .spatial_index
+            .get_or_init(|| Box::new(spatial::SpatialIndex::new(&self.children)));
+
+        let mut indices = Vec::new();
+        index.query(rect, &mut indices);
+        indices.sort_unstable();
+        for i in indices {
+            f(&self.children[i as usize]);
+        }
+    }
+
     /// Checks if this group should be isolated during rendering.
     pub fn should_isolate(&self) -> bool {
         self.isolate
@@ -1437,7 +1485,9 @@ pub enum ImageKind {
     /// A reference to raw WebP data. Should be decoded by the caller.
     WEBP(Arc<Vec<u8>>),
     /// A preprocessed SVG tree. Can be rendered as is.
-    SVG(Tree),
+    ///
+    /// Shared between all clones, like the ones created by `use`.
+    SVG(Arc<Tree>),
 }
 
 impl ImageKind {
@@ -1547,6 +1597,102 @@ impl Image {
     }
 }
 
+/// A shared instance of a subtree.
+///
+/// An element referenced by multiple `use` elements is converted only once
+/// and shared between all of them, unless its content depends on where it is placed,
+/// like text or context fills do.
+///
+/// The shared subtree is positioned in the parent coordinates,
+/// but absolute transforms and bounding boxes of its nodes are relative to the instance,
+/// just like for any other subroot.
+#[derive(Clone, Debug)]
+pub struct Instance {
+    pub(crate) root: Arc<Group>,
+    pub(crate) abs_transform: Transform,
+    pub(crate) abs_bounding_box: Rect,
+    pub(crate) abs_stroke_bounding_box: Rect,
+    pub(crate) abs_layer_bounding_box: NonZeroRect,
+}
+
+impl Instance {
+    pub(crate) fn new(root: Arc<Group>, abs_transform: Transform) -> Self {
+        let abs_bounding_box = root
+            .bounding_box
+            .transform(abs_transform)
+            .unwrap_or(root.bounding_box);
+        let abs_stroke_bounding_box = root
+            .stroke_bounding_box
+            .transform(abs_transform)
+            .unwrap_or(root.stroke_bounding_box);
+        let abs_layer_bounding_box = root
+            .layer_bounding_box
+            .transform(abs_transform)
+            .unwrap_or(root.layer_bounding_box);
+
+        Instance {
+            root,
+            abs_transform,
+            abs_bounding_box,
+            abs_stroke_bounding_box,
+            abs_layer_bounding_box,
+        }
+    }
+
+    /// The shared subtree.
+    ///
+    /// Always has an identity transform.
+    pub fn root(&self) -> &Group {
+        &self.root
+    }
+
+    /// Element's absolute transform.
+    ///
+    /// Contains all ancestors transforms.
+    /// Maps the shared subtree into canvas coordinates.
+    pub fn abs_transform(&self) -> Transform {
+        self.abs_transform
+    }
+
+    /// Element's object bounding box.
+    ///
+    /// Computed once per shared subtree.
+    pub fn bounding_box(&self) -> Rect {
+        self.root.bounding_box
+    }
+
+    /// Element's bounding box in canvas coordinates.
+    pub fn abs_bounding_box(&self) -> Rect {
+        self.abs_bounding_box
+    }
+
+    /// Element's bounding box including stroke in object coordinates.
+    pub fn stroke_bounding_box(&self) -> Rect {
+        self.root.stroke_bounding_box
+    }
+
+    /// Element's bounding box including stroke in canvas coordinates.
+    pub fn abs_stroke_bounding_box(&self) -> Rect {
+        self.abs_stroke_bounding_box
+    }
+
+    /// Element's "layer" bounding box in object units.
+    ///
+    /// See [`Group::layer_bounding_box`] for details.
+    pub fn layer_bounding_box(&self) -> NonZeroRect {
+        self.root.layer_bounding_box
+    }
+
+    /// Element's "layer" bounding box in canvas units.
+    pub fn abs_layer_bounding_box(&self) -> NonZeroRect {
+        self.abs_layer_bounding_box
+    }
+
+    fn subroots(&self, f: &mut dyn FnMut(&Group)) {
+        f(&self.root);
+    }
+}
+
 /// A nodes tree container.
 #[allow(missing_debug_implementations)]
 #[derive(Clone, Debug)]
@@ -1589,6 +1735,34 @@ impl Tree {
         node_by_id(&self.root, id)
     }
 
+    /// Returns nodes under a point in canvas coordinates.
+    ///
+    /// Nodes are returned in paint order, i.e. the topmost node is the last one.
+    /// A group is returned before its children and only when any of its children is hit.
+    ///
+    /// When `exact` is set, paths and text are tested against their fill and stroke geometry,
+    /// using the fill rule and stroke dashes. Otherwise, stroke bounding boxes are tested.
+    /// Images are always tested using their bounding boxes.
+    /// Clip paths and masks are ignored.
+    ///
+    /// Uses the same spatial index as rendering, so only nodes near the point are tested.
+    pub fn nodes_at_point(&self, x: f32, y: f32, exact: bool) -> Vec<&Node> {
+        match Rect::from_xywh(x, y, 0.0, 0.0) {
+            Some(rect) => self.nodes_in_rect(rect, exact),
+            None => Vec::new(),
+        }
+    }
+
+    /// Returns nodes intersecting a rectangle in canvas coordinates.
+    ///
+    /// Nodes are returned in the same order and tested the same way as in
+    /// [`Tree::nodes_at_point`].
+    pub fn nodes_in_rect(&self, rect: Rect, exact: bool) -> Vec<&Node> {
+        let mut nodes = Vec::new();
+        query::query_group(&self.root, self.root.transform, rect, exact, &mut nodes);
+        nodes
+    }
+
     /// Checks if the current tree has any text nodes.
     pub fn has_text_nodes(&self) -> bool {
         has_text_nodes(&self.root)
@@ -1630,6 +1804,52 @@ impl Tree {
         &self.fontdb
     }
 
+    /// Returns an approximate amount of memory used by the tree, in bytes.
+    ///
+    /// Data shared between nodes, like path data and paint servers, is accounted only once.
+    /// The font database is not included, since it is usually shared between trees.
+    pub fn memory_usage(&self) -> usize {
+        std::mem::size_of::<Tree>() + memory::MemoryCounter::default().tree(self)
+    }
+
+    /// Rewrites the tree into an equivalent one that is cheaper to render.
+    ///
+    /// - Removes invisible, fully transparent and empty paths, as well as empty groups.
+    /// - Ungroups groups that do not affect rendering, moving their transform
+    ///   into a single child group when they have one.
+    /// - Merges runs of adjacent paths with the same fill and without a stroke
+    ///   into a single path, when their bounding boxes neither overlap nor touch.
+    ///   Shapes that are less than a pixel apart at the render scale can still
+    ///   share anti-aliased edge pixels, which are blended slightly differently
+    ///   once merged.
+    ///
+    /// Nodes with a non-empty ID are preserved, so they can still be found via
+    /// [`Tree::node_by_id`]. Clip paths, masks, patterns, text
+    /// and shared instances are left as is.
+    ///
+    /// The optimized tree can be rendered as usual or saved via [`Tree::to_string`]
+    /// to produce pre-optimized SVG files.
+    pub fn optimize(&mut self) {
+        if !optimize::optimize_group(&mut self.root) {
+            return;
+        }
+
+        self.root.calculate_bounding_boxes();
+
+        // Removed nodes could have been the only users of some resources.
+        self.linear_gradients.clear();
+        self.radial_gradients.clear();
+        self.patterns.clear();
+        self.clip_paths.clear();
+        self.masks.clear();
+        self.filters.clear();
+
+        self.collect_paint_servers();
+        self.root.collect_clip_paths(&mut self.clip_paths);
+        self.root.collect_masks(&mut self.masks);
+        self.root.collect_filters(&mut self.filters);
+    }
+
     pub(crate) fn collect_paint_servers(&mut self) {
         loop_over_paint_servers(&self.root, &mut |paint| match paint {
             Paint::Color(_) => {}
@@ -1716,9 +1936,11 @@ fn loop_over_paint_servers(parent: &Group, f: &mut dyn FnMut(&Paint)) {
                 push(path.fill.as_ref().map(|f| &f.paint), f);
                 push(path.stroke.as_ref().map(|f| &f.paint), f);
             }
-            Node::Image(_) => {}
+            // Visited as a subroot.
+            Node::Image(_) | Node::Instance(_) => {}
             // Flattened text would be used instead.
-            Node::Text(_) => {}
+            // A lazy text might not be flattened yet, but its spans use the same paint servers.
+            Node::Text(ref text) => text.lazy_paints(f),
         }
 
         node.subroots(|subroot| loop_over_paint_servers(subroot, f));
@@ -1841,14 +2063,21 @@ impl Group {
 
             abs_stroke_bbox = abs_stroke_bbox.expand(child.abs_stroke_bounding_box());
 
-            if let Node::Group(ref group) = child {
-                let r = group.layer_bounding_box;
-                if let Some(r) = r.transform(group.transform) {
-                    layer_bbox = layer_bbox.expand(r);
+            match child {
+                Node::Group(ref group) => {
+                    let r = group.layer_bounding_box;
+                    if let Some(r) = r.transform(group.transform) {
+                        layer_bbox = layer_bbox.expand(r);
+                    }
+                }
+                // Instances do not have a transform, but can have filters inside.
+                Node::Instance(ref instance) => {
+                    layer_bbox = layer_bbox.expand(instance.root.layer_bounding_box);
+                }
+                _ => {
+                    // Not a group - no need to transform.
+                    layer_bbox = layer_bbox.expand(child.stroke_bounding_box());
                 }
-            } else {
-                // Not a group - no need to transform.
-                layer_bbox = layer_bbox.expand(child.stroke_bounding_box());
             }
         }
 
@@ -0,0 +1,215 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use std::sync::Arc;
+
+use tiny_skia_path::PathSegment;
+
+use super::*;
+
+/// The maximum number of paths merged into one.
+const MAX_MERGED_PATHS: usize = 256;
+
+/// Optimizes group children recursively.
+///
+/// Returns `true` when the group has changed and its bounding boxes have to be updated.
+pub(crate) fn optimize_group(group: &mut Group) -> bool {
+    let mut changed = false;
+
+    // Children are about to change, so the index would be stale.
+    group.spatial_index = Default::default();
+
+    let children = std::mem::take(&mut group.children);
+    group.children.reserve(children.len());
+    for mut node in children {
+        let mut replacement = None;
+        match node {
+            Node::Group(ref mut g) => {
+                if optimize_group(g) {
+                    g.calculate_bounding_boxes();
+                    changed = true;
+                }
+
+                // Filters can produce an image even without children, like `feFlood`.
+                if g.children.is_empty() && g.filters.is_empty() && g.id.is_empty() {
+                    changed = true;
+                    continue;
+                }
+
+                if is_transparent_group(g) {
+                    if g.transform.is_identity() {
+                        // Ungroup.
+                        group.children.append(&mut g.children);
+                        changed = true;
+                        continue;
+                    }
+
+                    // Move the transform into a single child group.
+                    if let [Node::Group(ref mut child)] = g.children.as_mut_slice() {
+                        child.transform = g.transform.pre_concat(child.transform);
+                        replacement = g.children.pop();
+                        changed = true;
+                    }
+                }
+            }
+            Node::Path(ref path) => {
+                if !is_path_visible(path) {
+                    changed = true;
+                    continue;
+                }
+            }
+            // Shared subtrees cannot be modified in place.
+            Node::Image(_) | Node::Text(_) | Node::Instance(_) => {}
+        }
+
+        if let Some(child) = replacement {
+            node = child;
+        }
+
+        group.children.push(node);
+    }
+
+    changed |= merge_paths(&mut group.children);
+    changed
+}
+
+/// Checks that a group can be removed without affecting rendering.
+fn is_transparent_group(group: &Group) -> bool {
+    // Groups with an ID are preserved, so they can still be referenced.
+    !group.should_isolate() && group.id.is_empty()
+}
+
+/// Checks that a path would produce any pixels.
+fn is_path_visible(path: &Path) -> bool {
+    if !path.visible {
+        return false;
+    }
+
+    let has_fill = match path.fill {
+        Some(ref fill) => {
+            let bbox = path.data.bounds();
+            fill.opacity != Opacity::ZERO && bbox.width() > 0.0 && bbox.height() > 0.0
+        }
+        None => false,
+    };
+
+    let has_stroke = match path.stroke {
+        Some(ref stroke) => stroke.opacity != Opacity::ZERO,
+        None => false,
+    };
+
+    // Paths with an ID are preserved, so they can still be referenced.
+    has_fill || has_stroke || !path.id.is_empty()
+}
+
+/// Merges runs of adjacent paths with the same fill into a single path.
+///
+/// Only paths without a stroke and with non-overlapping bounding boxes are merged,
+/// otherwise the overlapping areas could have been rendered differently.
+/// Touching boxes count as overlapping, since shapes sharing an edge
+/// would have their anti-aliased seam blended differently.
+fn merge_paths(nodes: &mut Vec<Node>) -> bool {
+    let mut changed = false;
+    let mut merged: Vec<Node> = Vec::with_capacity(nodes.len());
+    let mut run: Vec<Box<Path>> = Vec::new();
+
+    for node in nodes.drain(..) {
+        match node {
+            Node::Path(path) if is_mergeable(&path) => {
+                let fits = run.len() < MAX_MERGED_PATHS
+                    && run.first().map_or(true, |first| {
+                        same_fill(first, &path)
+                            && run
+                                .iter()
+                                .all(|p| !overlaps(p.bounding_box, path.bounding_box))
+                    });
+
+                if !fits {
+                    changed |= flush_run(&mut run, &mut merged);
+                }
+
+                run.push(path);
+            }
+            node => {
+                changed |= flush_run(&mut run, &mut merged);
+                merged.push(node);
+            }
+        }
+    }
+
+    changed |= flush_run(&mut run, &mut merged);
+
+    *nodes = merged;
+    changed
+}
+
+fn is_mergeable(path: &Path) -> bool {
+    path.visible && path.id.is_empty() && path.fill.is_some() && path.stroke.is_none()
+}
+
+fn same_fill(a: &Path, b: &Path) -> bool {
+    match (&a.fill, &b.fill) {
+        (Some(fill1), Some(fill2)) => {
+            fill1.paint == fill2.paint
+                && fill1.opacity == fill2.opacity
+                && fill1.rule == fill2.rule
+                && a.rendering_mode == b.rendering_mode
+        }
+        _ => false,
+    }
+}
+
+fn overlaps(a: Rect, b: Rect) -> bool {
+    a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom()
+}
+
+/// Moves the current run into `nodes`, merging it into a single path when possible.
+///
+/// Returns `true` when paths were merged.
+fn flush_run(run: &mut Vec<Box<Path>>, nodes: &mut Vec<Node>) -> bool {
+    if run.len() < 2 {
+        nodes.extend(run.drain(..).map(Node::Path));
+        return false;
+    }
+
+    let mut builder = tiny_skia_path::PathBuilder::new();
+    for path in run.iter() {
+        for seg in path.data.segments() {
+            match seg {
+                PathSegment::MoveTo(p) => builder.move_to(p.x, p.y),
+                PathSegment::LineTo(p) => builder.line_to(p.x, p.y),
+                PathSegment::QuadTo(p1, p) => builder.quad_to(p1.x, p1.y, p.x, p.y),
+                PathSegment::CubicTo(p1, p2, p) => {
+                    builder.cubic_to(p1.x, p1.y, p2.x, p2.y, p.x, p.y)
+                }
+                PathSegment::Close => builder.close(),
+            }
+        }
+    }
+
+    let first = &run[0];
+    let path = builder.finish().and_then(|data| {
+        Path::new(
+            String::new(),
+            true,
+            first.fill.clone(),
+            None,
+            first.paint_order,
+            first.rendering_mode,
+            Arc::new(data),
+            first.abs_transform,
+        )
+    });
+
+    match path {
+        Some(path) => {
+            nodes.push(Node::Path(Box::new(path)));
+            run.clear();
+            true
+        }
+        None => {
+            nodes.extend(run.drain(..).map(Node::Path));
+            false
+        }
+    }
+}
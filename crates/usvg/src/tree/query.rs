@@ -0,0 +1,244 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use kurbo::Shape;
+use tiny_skia_path::PathSegment;
+
+use super::*;
+
+/// Flattening tolerance for exact tests, in canvas units.
+const TOLERANCE: f64 = 0.1;
+
+/// Collects nodes intersecting `rect` in paint order.
+///
+/// `rect` is in canvas coordinates, while `ts` maps group children into canvas coordinates.
+/// Groups are collected before their children and only when any of them matches.
+pub(crate) fn query_group<'a>(
+    group: &'a Group,
+    ts: Transform,
+    rect: Rect,
+    exact: bool,
+    nodes: &mut Vec<&'a Node>,
+) {
+    let local = match ts.invert().and_then(|inv| transform_rect(rect, inv)) {
+        Some(v) => v,
+        // Nothing would be rendered with a non-invertible transform.
+        None => return,
+    };
+
+    group.children_in_rect(local, |node| match node {
+        Node::Group(ref g) => {
+            let idx = nodes.len();
+            query_group(g, ts.pre_concat(g.transform), rect, exact, nodes);
+            if nodes.len() > idx {
+                nodes.insert(idx, node);
+            }
+        }
+        Node::Path(ref path) => {
+            if path.visible && is_path_hit(path, ts, rect, exact) {
+                nodes.push(node);
+            }
+        }
+        Node::Instance(ref instance) => {
+            let idx = nodes.len();
+            query_group(&instance.root, ts, rect, exact, nodes);
+            if nodes.len() > idx {
+                nodes.insert(idx, node);
+            }
+        }
+        Node::Image(ref image) => {
+            if image.visible && is_bbox_hit(image.bounding_box(), ts, rect) {
+                nodes.push(node);
+            }
+        }
+        Node::Text(ref text) => {
+            let is_hit = if exact {
+                let flattened = text.flattened();
+                let mut paths = Vec::new();
+                query_group(
+                    flattened,
+                    ts.pre_concat(flattened.transform),
+                    rect,
+                    exact,
+                    &mut paths,
+                );
+                !paths.is_empty()
+            } else {
+                is_bbox_hit(text.stroke_bounding_box(), ts, rect)
+            };
+
+            if is_hit {
+                nodes.push(node);
+            }
+        }
+    });
+}
+
+fn is_bbox_hit(bbox: Rect, ts: Transform, rect: Rect) -> bool {
+    match transform_rect(bbox, ts) {
+        Some(bbox) => super::spatial::intersects(bbox, rect),
+        None => false,
+    }
+}
+
+fn is_path_hit(path: &Path, ts: Transform, rect: Rect, exact: bool) -> bool {
+    if !is_bbox_hit(path.stroke_bounding_box, ts, rect) {
+        return false;
+    }
+
+    if !exact {
+        return true;
+    }
+
+    if let Some(ref fill) = path.fill {
+        let even_odd = fill.rule == FillRule::EvenOdd;
+        if is_outline_hit(&to_kurbo(&path.data, ts), rect, even_odd) {
+            return true;
+        }
+    }
+
+    if let Some(ref stroke) = path.stroke {
+        // Unlike bounding boxes, dashes are accounted here.
+        // The stroker approximates curves in user space, so its precision has to account
+        // for the canvas scale, the same way it does during rendering.
+        let res_scale = tiny_skia_path::PathStroker::compute_resolution_scale(&ts);
+        if let Some(outline) = path.data.stroke(&stroke.to_tiny_skia(), res_scale) {
+            if is_outline_hit(&to_kurbo(&outline, ts), rect, false) {
+                return true;
+            }
+        }
+    }
+
+    false
+}
+
+/// Converts a path into canvas coordinates, closing all subpaths.
+fn to_kurbo(path: &tiny_skia_path::Path, ts: Transform) -> kurbo::BezPath {
+    let map = |mut p: tiny_skia_path::Point| {
+        ts.map_point(&mut p);
+        kurbo::Point::new(p.x as f64, p.y as f64)
+    };
+
+    let mut bez = kurbo::BezPath::new();
+    let mut is_open = false;
+    for seg in path.segments() {
+        match seg {
+            PathSegment::MoveTo(p) => {
+                if is_open {
+                    bez.close_path();
+                }
+
+                bez.move_to(map(p));
+                is_open = true;
+            }
+            PathSegment::LineTo(p) => bez.line_to(map(p)),
+            PathSegment::QuadTo(p1, p) => bez.quad_to(map(p1), map(p)),
+            PathSegment::CubicTo(p1, p2, p) => bez.curve_to(map(p1), map(p2), map(p)),
+            PathSegment::Close => {
+                bez.close_path();
+                is_open = false;
+            }
+        }
+    }
+
+    if is_open {
+        bez.close_path();
+    }
+
+    bez
+}
+
+/// Checks that a filled outline intersects a rectangle.
+///
+/// This is the case when either the rectangle center is inside the outline
+/// or an outline edge crosses the rectangle.
+/// Otherwise, the rectangle is either entirely outside the outline or inside a hole.
+fn is_outline_hit(outline: &kurbo::BezPath, rect: Rect, even_odd: bool) -> bool {
+    let center = kurbo::Point::new(
+        (rect.left() as f64 + rect.right() as f64) / 2.0,
+        (rect.top() as f64 + rect.bottom() as f64) / 2.0,
+    );
+
+    let winding = outline.winding(center);
+    if (even_odd && winding % 2 != 0) || (!even_odd && winding != 0) {
+        return true;
+    }
+
+    let mut is_hit = false;
+    let mut start = kurbo::Point::ZERO;
+    let mut prev = kurbo::Point::ZERO;
+    outline.flatten(TOLERANCE, |el| match el {
+        kurbo::PathEl::MoveTo(p) => {
+            start = p;
+            prev = p;
+        }
+        kurbo::PathEl::LineTo(p) => {
+            is_hit |= is_segment_hit(prev, p, rect);
+            prev = p;
+        }
+        kurbo::PathEl::ClosePath => {
+            is_hit |= is_segment_hit(prev, start, rect);
+            prev = start;
+        }
+        _ => {}
+    });
+
+    is_hit
+}
+
+/// Checks that a line segment intersects a rectangle, using Liang-Barsky clipping.
+fn is_segment_hit(p0: kurbo::Point, p1: kurbo::Point, rect: Rect) -> bool {
+    let d = p1 - p0;
+    let edges = [
+        (-d.x, p0.x - rect.left() as f64),
+        (d.x, rect.right() as f64 - p0.x),
+        (-d.y, p0.y - rect.top() as f64),
+        (d.y, rect.bottom() as f64 - p0.y),
+    ];
+
+    let mut t0 = 0.0;
+    let mut t1 = 1.0;
+    for (p, q) in edges {
+        if p == 0.0 {
+            // Parallel to the edge and outside of it.
+            if q < 0.0 {
+                return false;
+            }
+        } else {
+            let t = q / p;
+            if p < 0.0 {
+                if t > t1 {
+                    return false;
+                }
+                t0 = f64::max(t0, t);
+            } else {
+                if t < t0 {
+                    return false;
+                }
+                t1 = f64::min(t1, t);
+            }
+        }
+    }
+
+    true
+}
+
+/// Returns a bounding box of a transformed rectangle.
+///
+/// Unlike `Rect::transform`, supports zero-sized rectangles.
+fn transform_rect(rect: Rect, ts: Transform) -> Option<Rect> {
+    let mut points = [
+        tiny_skia_path::Point::from_xy(rect.left(), rect.top()),
+        tiny_skia_path::Point::from_xy(rect.right(), rect.top()),
+        tiny_skia_path::Point::from_xy(rect.right(), rect.bottom()),
+        tiny_skia_path::Point::from_xy(rect.left(), rect.bottom()),
+    ];
+    ts.map_points(&mut points);
+
+    let mut bbox = BBox::default();
+    for p in points {
+        bbox = bbox.expand(Rect::from_xywh(p.x, p.y, 0.0, 0.0)?);
+    }
+
+    bbox.to_rect()
+}
@@ -0,0 +1,152 @@
+// Copyright 2026 the Resvg Authors
+// SPDX-License-Identifier: Apache-2.0 OR MIT
+
+use super::{Node, Rect};
+
+/// The minimal number of children to build an index for.
+///
+/// Smaller groups are simply tested child by child.
+pub(crate) const MIN_INDEXED_CHILDREN: usize = 64;
+
+/// The maximal number of children in a leaf.
+const LEAF_SIZE: usize = 8;
+
+/// Returns a child's layer bounding box in its parent coordinates.
+///
+/// The same box is used to calculate the parent's layer bounding box.
+pub(crate) fn layer_bounding_box(node: &Node) -> Rect {
+    match node {
+        Node::Group(ref group) => match group.layer_bounding_box.transform(group.transform) {
+            Some(r) => r.to_rect(),
+            // A non-invertible transform. Nothing would be rendered anyway.
+            None => group.layer_bounding_box.to_rect(),
+        },
+        Node::Instance(ref instance) => instance.root.layer_bounding_box.to_rect(),
+        _ => node.stroke_bounding_box(),
+    }
+}
+
+/// Checks that two rectangles intersect, including touching edges.
+#[inline]
+pub(crate) fn intersects(a: Rect, b: Rect) -> bool {
+    a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom()
+}
+
+/// A bounding volume hierarchy over group children.
+#[derive(Clone, Debug)]
+pub(crate) struct SpatialIndex {
+    nodes: Vec<IndexNode>,
+    /// Children bounding boxes and indices, ordered by leaves.
+    items: Vec<(Rect, u32)>,
+}
+
+#[derive(Clone, Copy, Debug)]
+struct IndexNode {
+    bbox: Rect,
+    /// For leaves, the first item in `items`.
+    /// For inner nodes, the second child node, while the first one follows this node.
+    start: u32,
+    /// The number of items in a leaf. Zero for inner nodes.
+    count: u32,
+}
+
+impl SpatialIndex {
+    /// Builds an index over children layer bounding boxes.
+    ///
+    /// `children` must not be empty.
+    pub(crate) fn new(children: &[Node]) -> Self {
+        let mut items: Vec<(Rect, u32)> = children
+            .iter()
+            .enumerate()
+            .map(|(i, child)| (layer_bounding_box(child), i as u32))
+            .collect();
+
+        let mut index = SpatialIndex {
+            nodes: Vec::with_capacity(items.len() / LEAF_SIZE * 2 + 1),
+            items: Vec::new(),
+        };
+        index.build(&mut items, 0);
+        index.items = items;
+        index
+    }
+
+    /// Splits items at the median along the longest axis, until they fit into a leaf.
+    ///
+    /// Reorders `items` in place, so each leaf refers to a continuous range.
+    /// `offset` is the position of `items` in the whole list.
+    fn build(&mut self, items: &mut [(Rect, u32)], offset: usize) {
+        let bbox = items[1..]
+            .iter()
+            .fold(items[0].0, |bbox, item| union(bbox, item.0));
+
+        if items.len() <= LEAF_SIZE {
+            self.nodes.push(IndexNode {
+                bbox,
+                start: offset as u32,
+                count: items.len() as u32,
+            });
+            return;
+        }
+
+        let idx = self.nodes.len();
+        self.nodes.push(IndexNode {
+            bbox,
+            start: 0,
+            count: 0,
+        });
+
+        let mid = items.len() / 2;
+        if bbox.width() >= bbox.height() {
+            let center = |r: &Rect| r.left() + r.right();
+            items.select_nth_unstable_by(mid, |a, b| center(&a.0).total_cmp(&center(&b.0)));
+        } else {
+            let center = |r: &Rect| r.top() + r.bottom();
+            items.select_nth_unstable_by(mid, |a, b| center(&a.0).total_cmp(&center(&b.0)));
+        }
+
+        let (first, second) = items.split_at_mut(mid);
+        self.build(first, offset);
+        self.nodes[idx].start = self.nodes.len() as u32;
+        self.build(second, offset + mid);
+    }
+
+    /// Appends indices of children intersecting `rect` to `result`, in no particular order.
+    pub(crate) fn query(&self, rect: Rect, result: &mut Vec<u32>) {
+        let mut stack = Vec::with_capacity(32);
+        stack.push(0);
+        while let Some(idx) = stack.pop() {
+            let node = &self.nodes[idx];
+            if !intersects(node.bbox, rect) {
+                continue;
+            }
+
+            if node.count == 0 {
+                stack.push(node.start as usize);
+                stack.push(idx + 1);
+                continue;
+            }
+
+            let start = node.start as usize;
+            for (bbox, i) in &self.items[start..start + node.count as usize] {
+                if intersects(*bbox, rect) {
+                    result.push(*i);
+                }
+            }
+        }
+    }
+
+    pub(crate) fn memory_usage(&self) -> usize {
+        self.nodes.capacity() * std::mem::size_of::<IndexNode>()
+            + self.items.capacity() * std::mem::size_of::<(Rect, u32)>()
+    }
+}
+
+fn union(a: Rect, b: Rect) -> Rect {
+    Rect::from_ltrb(
+        a.left().min(b.left()),
+        a.top().min(b.top()),
+        a.right().max(b.right()),
+        a.bottom().max(b.bottom()),
+    )
+    .unwrap_or(a)
+}
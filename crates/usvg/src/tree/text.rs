@@ -3,12 +3,15 @@
 
 use std::sync::Arc;
 
+use once_cell::sync::OnceCell;
 use strict_num::NonZeroPositiveF32;
 pub use svgtypes::FontFamily;
 
 #[cfg(feature = "text")]
 use crate::layout::Span;
-use crate::{Fill, Group, NonEmptyString, PaintOrder, Rect, Stroke, TextRendering, Transform};
+use crate::{
+    Fill, Group, NonEmptyString, Paint, PaintOrder, Rect, Stroke, TextRendering, Transform,
+};
 
 /// A font stretch property.
 #[allow(missing_docs)]
@@ -519,9 +522,14 @@ pub struct Text {
     pub(crate) abs_bounding_box: Rect,
     pub(crate) stroke_bounding_box: Rect,
     pub(crate) abs_stroke_bounding_box: Rect,
-    pub(crate) flattened: Box<Group>,
+    pub(crate) flattened: OnceCell<Box<Group>>,
     #[cfg(feature = "text")]
     pub(crate) layouted: Vec<Span>,
+    /// A font database to flatten the text with on the first access.
+    ///
+    /// Set only when [`Options::lazy_text`](crate::Options::lazy_text) is enabled.
+    #[cfg(feature = "text")]
+    pub(crate) fontdb: Option<Arc<fontdb::Database>>,
 }
 
 impl Text {
@@ -634,8 +642,22 @@ impl Text {
     ///    cause any issues in 95% of the cases, as most of those are edge cases.
     ///    If the two above are not acceptable, then you will need to implement your own
     ///    glyph rendering logic based on the layouted glyphs (see the `layouted` method).
+    ///
+    /// When the tree was parsed with [`Options::lazy_text`](crate::Options::lazy_text),
+    /// the text is flattened on the first call and the result is cached.
     pub fn flattened(&self) -> &Group {
-        &self.flattened
+        self.flattened.get_or_init(|| {
+            #[cfg(feature = "text")]
+            {
+                if let Some(ref fontdb) = self.fontdb {
+                    if let Some(group) = crate::text::flatten(self, fontdb) {
+                        return Box::new(group);
+                    }
+                }
+            }
+
+            Box::new(Group::empty())
+        })
     }
 
     /// The positioned glyphs and decoration spans of the text.
@@ -649,6 +671,47 @@ impl Text {
     }
 
     pub(crate) fn subroots(&self, f: &mut dyn FnMut(&Group)) {
-        f(&self.flattened);
+        // Do not flatten a lazy text just to iterate over it.
+        // Its patterns are reachable via the layouted spans instead.
+        if let Some(flattened) = self.flattened.get() {
+            f(flattened);
+        }
+
+        self.lazy_paints(&mut |paint| {
+            if let Paint::Pattern(ref patt) = paint {
+                f(patt.root());
+            }
+        });
+    }
+
+    /// Calls `f` for fills and strokes of the layouted spans and decorations,
+    /// unless the text is already flattened.
+    ///
+    /// A flattened text uses the same paint servers, so this allows collecting them
+    /// without flattening a lazy text.
+    pub(crate) fn lazy_paints(&self, f: &mut dyn FnMut(&Paint)) {
+        #[cfg(feature = "text")]
+        if self.flattened.get().is_none() {
+            let mut push = |fill: Option<&Fill>, stroke: Option<&Stroke>| {
+                if let Some(fill) = fill {
+                    f(&fill.paint);
+                }
+                if let Some(stroke) = stroke {
+                    f(&stroke.paint);
+                }
+            };
+
+            for span in &self.layouted {
+                push(span.fill.as_ref(), span.stroke.as_ref());
+
+                let decorations = [&span.underline, &span.overline, &span.line_through];
+                for path in decorations.into_iter().flatten() {
+                    push(path.fill(), path.stroke());
+                }
+            }
+        }
+
+        #[cfg(not(feature = "text"))]
+        let _ = f;
     }
 }
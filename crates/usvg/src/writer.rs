@@ -667,6 +667,10 @@ fn write_element(node: &Node, is_clip_path: bool, opt: &WriteOptions, xml: &mut
         Node::Group(ref g) => {
             write_group_element(g, is_clip_path, opt, xml);
         }
+        Node::Instance(ref instance) => {
+            // The shared subtree root doesn't affect rendering, so only its children are written.
+            write_elements(&instance.root, is_clip_path, opt, xml);
+        }
         Node::Text(ref text) => {
             if opt.preserve_text {
                 xml.start_svg_element(EId::Text);
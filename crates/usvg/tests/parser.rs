@@ -155,6 +155,149 @@ fn stylesheet_injection_with_important() {
     );
 }
 
+#[test]
+fn compiled_stylesheet_injection() {
+    let svg = "<svg viewBox='0 0 200 200' xmlns='http://www.w3.org/2000/svg'>
+    <style>
+        #rect2 { fill: green }
+    </style>
+    <rect id='rect1' width='10' height='10'/>
+    <rect id='rect2' width='10' height='10'/>
+    <rect id='rect3' class='a' width='10' height='10'/>
+</svg>
+";
+
+    let options = usvg::Options {
+        compiled_style_sheet: Some(std::sync::Arc::new(usvg::CompiledStyleSheet::parse(
+            "rect { fill: red } rect.a { fill: blue }",
+        ))),
+        ..usvg::Options::default()
+    };
+
+    // The same stylesheet can be used by multiple documents.
+    for _ in 0..2 {
+        let tree = usvg::Tree::from_str(&svg, &options).unwrap();
+        let fills: Vec<_> = tree
+            .root()
+            .children()
+            .iter()
+            .map(|node| match node {
+                usvg::Node::Path(ref path) => path.fill().unwrap().paint().clone(),
+                _ => unreachable!(),
+            })
+            .collect();
+
+        assert_eq!(
+            fills,
+            vec![
+                usvg::Paint::Color(Color::new_rgb(255, 0, 0)),
+                usvg::Paint::Color(Color::new_rgb(0, 128, 0)),
+                usvg::Paint::Color(Color::new_rgb(0, 0, 255)),
+            ]
+        );
+    }
+}
+
+#[test]
+fn compiled_stylesheet_selectors() {
+    let svg = "<svg viewBox='0 0 200 200' xmlns='http://www.w3.org/2000/svg'>
+    <g class='x'>
+        <rect id='rect1' width='10' height='10'/>
+        <rect id='rect2' class='a b' width='10' height='10'/>
+        <g><rect id='rect3' width='10' height='10'/></g>
+    </g>
+    <rect id='rect4' width='10' height='10'/>
+</svg>
+";
+
+    let css = "
+        * { fill: red }
+        .x rect { fill: blue }
+        .x > rect:first-child { fill: green }
+        rect + .a.b { fill: yellow }
+        g g > [id^='rect3'] { fill: black }
+        #rect4 { fill: white }
+    ";
+
+    fn collect_fills(parent: &usvg::Group, fills: &mut Vec<usvg::Paint>) {
+        for node in parent.children() {
+            match node {
+                usvg::Node::Group(ref group) => collect_fills(group, fills),
+                usvg::Node::Path(ref path) => fills.push(path.fill().unwrap().paint().clone()),
+                _ => {}
+            }
+        }
+    }
+
+    let fills = |options: &usvg::Options| {
+        let tree = usvg::Tree::from_str(&svg, options).unwrap();
+        let mut fills = Vec::new();
+        collect_fills(tree.root(), &mut fills);
+        fills
+    };
+
+    let compiled = fills(&usvg::Options {
+        compiled_style_sheet: Some(std::sync::Arc::new(usvg::CompiledStyleSheet::parse(css))),
+        ..usvg::Options::default()
+    });
+
+    // A compiled stylesheet must match exactly like a regular one.
+    let regular = fills(&usvg::Options {
+        style_sheet: Some(css.to_string()),
+        ..usvg::Options::default()
+    });
+
+    assert_eq!(compiled, regular);
+    assert_eq!(
+        compiled,
+        vec![
+            usvg::Paint::Color(Color::new_rgb(0, 128, 0)),
+            usvg::Paint::Color(Color::new_rgb(255, 255, 0)),
+            usvg::Paint::Color(Color::new_rgb(0, 0, 0)),
+            usvg::Paint::Color(Color::new_rgb(255, 255, 255)),
+        ]
+    );
+}
+
+#[test]
+fn stylesheet_rules_order() {
+    let svg = "<svg viewBox='0 0 200 200' xmlns='http://www.w3.org/2000/svg'>
+    <style>
+        rect { fill: red }
+        .a { fill: red }
+        .a.b { fill: green }
+        g > .c { fill: green }
+        [id='rect3'] { fill: green }
+    </style>
+    <rect class='b a b' width='10' height='10'/>
+    <g opacity='0.5'>
+        <rect class='c' width='10' height='10'/>
+    </g>
+    <rect id='rect3' width='10' height='10'/>
+    <rect class='c' width='10' height='10'/>
+</svg>
+";
+
+    fn collect_fills(parent: &usvg::Group, fills: &mut Vec<usvg::Paint>) {
+        for node in parent.children() {
+            match node {
+                usvg::Node::Group(ref group) => collect_fills(group, fills),
+                usvg::Node::Path(ref path) => fills.push(path.fill().unwrap().paint().clone()),
+                _ => {}
+            }
+        }
+    }
+
+    let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+    let mut fills = Vec::new();
+    collect_fills(tree.root(), &mut fills);
+
+    // Rules from different index buckets must still be applied in order.
+    let green = usvg::Paint::Color(Color::new_rgb(0, 128, 0));
+    let red = usvg::Paint::Color(Color::new_rgb(255, 0, 0));
+    assert_eq!(fills, vec![green.clone(), green.clone(), green, red]);
+}
+
 #[test]
 fn simplify_paths() {
     let svg = "
@@ -502,3 +645,269 @@ fn svg_without_xmlns() {
     let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
     assert_eq!(tree.size(), usvg::Size::from_wh(100.0, 100.0).unwrap());
 }
+
+#[test]
+fn use_instances_share_subtree() {
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'
+         xmlns:xlink='http://www.w3.org/1999/xlink'>
+        <defs>
+            <path id='marker' d='M 0 0 L 10 0 L 10 10 Z'/>
+        </defs>
+        <use xlink:href='#marker'/>
+        <use xlink:href='#marker' x='20'/>
+        <use xlink:href='#marker' fill='green'/>
+    </svg>
+    ";
+
+    let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+
+    let instances: Vec<&usvg::Instance> = tree
+        .root()
+        .children()
+        .iter()
+        .map(|node| match node {
+            usvg::Node::Group(ref group) => match group.children() {
+                [usvg::Node::Instance(ref instance)] => &**instance,
+                _ => unreachable!(),
+            },
+            _ => unreachable!(),
+        })
+        .collect();
+
+    assert_eq!(instances.len(), 3);
+    assert!(std::ptr::eq(instances[0].root(), instances[1].root()));
+    // A different inherited fill produces a different subtree.
+    assert!(!std::ptr::eq(instances[0].root(), instances[2].root()));
+
+    assert!(matches!(
+        instances[0].root().children(),
+        [usvg::Node::Path(_)]
+    ));
+    assert_eq!(instances[0].bounding_box(), instances[1].bounding_box());
+    assert_eq!(instances[1].abs_bounding_box().x(), 20.0);
+    assert_eq!(tree.root().children()[1].abs_bounding_box().x(), 20.0);
+}
+
+#[test]
+fn identical_shapes_share_path_data() {
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <rect width='10' height='10' fill='green'/>
+        <path d='M 0 0 H 10 V 10 H 0 Z' fill='blue'/>
+        <rect width='10' height='10' fill='red'/>
+    </svg>
+    ";
+
+    let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+
+    let paths: Vec<_> = tree
+        .root()
+        .children()
+        .iter()
+        .map(|node| match node {
+            usvg::Node::Path(ref path) => path.data() as *const usvg::tiny_skia_path::Path,
+            _ => unreachable!(),
+        })
+        .collect();
+
+    assert_eq!(paths.len(), 3);
+    assert!(std::ptr::eq(paths[0], paths[2]));
+    assert!(tree.memory_usage() > 0);
+}
+
+#[test]
+fn optimize_merges_paths() {
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <rect width='10' height='10' fill='green'/>
+        <rect x='5' width='10' height='10' fill='green' fill-opacity='0'/>
+        <rect x='20' width='10' height='10' fill='green'/>
+        <rect id='rect1' x='40' width='10' height='10' fill='green'/>
+    </svg>
+    ";
+
+    let mut tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+    tree.optimize();
+
+    let children = tree.root().children();
+    assert_eq!(children.len(), 2);
+    match children[0] {
+        usvg::Node::Path(ref path) => {
+            assert_eq!(
+                path.bounding_box(),
+                usvg::Rect::from_ltrb(0.0, 0.0, 30.0, 10.0).unwrap()
+            );
+        }
+        _ => unreachable!(),
+    }
+    assert!(tree.node_by_id("rect1").is_some());
+}
+
+#[test]
+fn children_in_rect() {
+    let mut svg = String::from("<svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>");
+    for y in 0..10 {
+        for x in 0..10 {
+            svg.push_str(&format!(
+                "<rect x='{}' y='{}' width='5' height='5'/>",
+                x * 10,
+                y * 10
+            ));
+        }
+    }
+    svg.push_str("</svg>");
+
+    let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+    let root = tree.root();
+    assert_eq!(root.children().len(), 100);
+
+    let rect = usvg::Rect::from_ltrb(12.0, 22.0, 31.0, 38.0).unwrap();
+    let mut found = Vec::new();
+    root.children_in_rect(rect, |node| {
+        let idx = root
+            .children()
+            .iter()
+            .position(|n| std::ptr::eq(n, node))
+            .unwrap();
+        found.push(idx);
+    });
+
+    // Columns 1-3 of rows 2-3, in paint order.
+    assert_eq!(found, vec![21, 22, 23, 31, 32, 33]);
+}
+
+#[test]
+fn nodes_at_point() {
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <g id='g1' transform='translate(10 10)'>
+            <circle id='circle1' cx='20' cy='20' r='20'/>
+            <rect id='rect1' x='20' y='20' width='40' height='40'
+                  fill='none' stroke='black' stroke-width='4'/>
+        </g>
+    </svg>
+    ";
+
+    let tree = usvg::Tree::from_str(&svg, &usvg::Options::default()).unwrap();
+    let ids = |nodes: Vec<&usvg::Node>| -> Vec<String> {
+        nodes.iter().map(|n| n.id().to_string()).collect()
+    };
+
+    // Inside the circle and the rect bbox, but not on the rect stroke.
+    assert_eq!(
+        ids(tree.nodes_at_point(40.0, 40.0, true)),
+        ["g1", "circle1"]
+    );
+    assert_eq!(
+        ids(tree.nodes_at_point(40.0, 40.0, false)),
+        ["g1", "circle1", "rect1"]
+    );
+
+    // Inside the circle bbox corner, but outside the circle itself.
+    assert!(tree.nodes_at_point(12.0, 12.0, true).is_empty());
+
+    // On the rect stroke.
+    assert_eq!(ids(tree.nodes_at_point(70.0, 50.0, true)), ["g1", "rect1"]);
+
+    let rect = usvg::Rect::from_xywh(45.0, 45.0, 10.0, 10.0).unwrap();
+    assert!(tree.nodes_in_rect(rect, true).is_empty());
+    assert_eq!(
+        ids(tree.nodes_in_rect(rect, false)),
+        ["g1", "circle1", "rect1"]
+    );
+}
+
+#[test]
+fn parse_limits() {
+    let parse = |svg: &str, limits: usvg::Limits| {
+        let opt = usvg::Options {
+            limits,
+            ..usvg::Options::default()
+        };
+        usvg::Tree::from_str(svg, &opt)
+    };
+
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <path id='path1' d='M 10 10 L 20 20'/>
+        <use href='#path1'/>
+        <use href='#path1'/>
+        <use href='#path1'/>
+    </svg>
+    ";
+
+    assert!(parse(svg, usvg::Limits::default()).is_ok());
+
+    let limits = usvg::Limits {
+        max_elements: 4,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::ElementsLimitReached)
+    ));
+
+    // Each `use` adds a copy of the referenced path.
+    let limits = usvg::Limits {
+        max_nodes: 5,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::NodesLimitReached)
+    ));
+
+    let limits = usvg::Limits {
+        max_path_points: 7,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::PathPointsLimitReached)
+    ));
+
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <g><g><g><rect width='10' height='10'/></g></g></g>
+    </svg>
+    ";
+
+    let limits = usvg::Limits {
+        max_depth: 3,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::DepthLimitReached)
+    ));
+
+    // A nested SVG image with two lines, 116 bytes long.
+    let svg = "
+    <svg viewBox='0 0 100 100' xmlns='http://www.w3.org/2000/svg'>
+        <path d='M 10 10 L 20 20'/>
+        <image width='10' height='10' href='data:image/svg+xml;base64,PHN2ZyB4bWxucz0naHR0cDovL3d3dy53My5vcmcvMjAwMC9zdmcnIHZpZXdCb3g9JzAgMCAxMCAxMCc+PHBhdGggZD0nTSAwIDAgTCAxMCAxMCcvPjxwYXRoIGQ9J00gMTAgMCBMIDAgMTAnLz48L3N2Zz4='/>
+    </svg>
+    ";
+
+    assert!(parse(svg, usvg::Limits::default()).is_ok());
+
+    // Nested images share the document limits.
+    let limits = usvg::Limits {
+        max_path_points: 5,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::PathPointsLimitReached)
+    ));
+
+    let limits = usvg::Limits {
+        max_image_bytes: 100,
+        ..usvg::Limits::default()
+    };
+    assert!(matches!(
+        parse(svg, limits),
+        Err(usvg::Error::ImageBytesLimitReached)
+    ));
+}
@@ -17,23 +17,28 @@ static GLOBAL_FONTDB: Lazy<Arc<usvg::fontdb::Database>> = Lazy::new(|| {
 });
 
 fn resave(name: &str) {
-    resave_impl(name, None, false);
+    resave_impl(name, None, false, false);
 }
 
 fn resave_with_text(name: &str) {
-    resave_impl(name, None, true);
+    resave_impl(name, None, true, false);
 }
 
 fn resave_with_prefix(name: &str, id_prefix: &str) {
-    resave_impl(name, Some(id_prefix.to_string()), false);
+    resave_impl(name, Some(id_prefix.to_string()), false, false);
 }
 
-fn resave_impl(name: &str, id_prefix: Option<String>, preserve_text: bool) {
+fn resave_with_lazy_text(name: &str) {
+    resave_impl(name, None, false, true);
+}
+
+fn resave_impl(name: &str, id_prefix: Option<String>, preserve_text: bool, lazy_text: bool) {
     let input_svg = std::fs::read_to_string(format!("tests/files/{}.svg", name)).unwrap();
 
     let tree = {
         let opt = usvg::Options {
             fontdb: GLOBAL_FONTDB.clone(),
+            lazy_text,
             ..Default::default()
         };
         usvg::Tree::from_str(&input_svg, &opt).unwrap()
@@ -154,6 +159,12 @@ fn text_with_generated_gradients() {
     resave("text-with-generated-gradients");
 }
 
+#[test]
+fn text_with_generated_gradients_lazy() {
+    // Text is flattened only while writing, but its gradients must be written as well.
+    resave_with_lazy_text("text-with-generated-gradients");
+}
+
 #[test]
 fn preserve_text_multiple_font_families() {
     resave_with_text("preserve-text-multiple-font-families");
@@ -25,6 +25,11 @@ QRect SvgViewWorker::viewBox() const
     return m_renderer.viewBox();
 }
 
+void SvgViewWorker::setRequestId(int requestId)
+{
+    m_requestId.storeRelease(requestId);
+}
+
 QString SvgViewWorker::loadData(const QByteArray &data)
 {
     QMutexLocker lock(&m_mutex);
@@ -50,26 +55,33 @@ QString SvgViewWorker::loadFile(const QString &path)
     return QString();
 }
 
-void SvgViewWorker::render(const QSize &viewSize)
+void SvgViewWorker::render(const QSize &viewSize, int requestId, bool isDraft)
 {
     Q_ASSERT(QThread::currentThread() != qApp->thread());
 
+    // A newer request was made while this one was queued.
+    if (requestId != m_requestId.loadAcquire()) {
+        return;
+    }
+
     QMutexLocker lock(&m_mutex);
 
     if (m_renderer.isEmpty()) {
         return;
     }
 
+    const auto s = m_renderer.defaultSize().scaled(viewSize, Qt::KeepAspectRatio);
+
     QElapsedTimer timer;
     timer.start();
 
-    const auto s = m_renderer.defaultSize().scaled(viewSize, Qt::KeepAspectRatio);
-    auto img = m_renderer.renderToImage(s * m_dpiRatio);
+    const auto quality = isDraft ? RESVG_QUALITY_DRAFT : RESVG_QUALITY_NORMAL;
+    auto img = m_renderer.renderToImage(s * m_dpiRatio, quality);
     img.setDevicePixelRatio(m_dpiRatio);
 
-    qDebug() << QString("Render in %1ms").arg(timer.elapsed());
+    qDebug() << QString("%1 in %2ms").arg(isDraft ? "Draft render" : "Render").arg(timer.elapsed());
 
-    emit rendered(img);
+    emit rendered(img, requestId, isDraft);
 }
 
 static QImage genCheckedTexture()
@@ -301,17 +313,36 @@ void SvgView::requestUpdate()
 
     m_timer.start(100, this);
 
+    // Renders of previous requests are no longer needed.
+    m_requestId++;
+    m_requestedSize = s;
+    m_worker->setRequestId(m_requestId);
+
+    // Show a fast draft first and then refine it.
     // Run method in the m_worker thread scope.
-    QTimer::singleShot(1, m_worker, [this, s](){
-        m_worker->render(s);
+    const int id = m_requestId;
+    QTimer::singleShot(1, m_worker, [this, s, id](){
+        m_worker->render(s, id, true);
     });
 }
 
-void SvgView::onRendered(const QImage &img)
+void SvgView::onRendered(const QImage &img, int requestId, bool isDraft)
 {
+    if (requestId != m_requestId) {
+        return;
+    }
+
     m_timer.stop();
 
     m_img = img;
     update();
+
+    if (isDraft) {
+        // The draft is shown already, so render the final image in the background.
+        const auto s = m_requestedSize;
+        QTimer::singleShot(1, m_worker, [this, s, requestId](){
+            m_worker->render(s, requestId, false);
+        });
+    }
 }
 
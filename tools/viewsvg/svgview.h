@@ -5,6 +5,7 @@
 
 #include <QWidget>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QBasicTimer>
 
 #include <ResvgQt.h>
@@ -18,17 +19,21 @@ public:
 
     QRect viewBox() const;
 
+    // Renders of other requests will be skipped.
+    void setRequestId(int requestId);
+
 public slots:
     QString loadData(const QByteArray &data);
     QString loadFile(const QString &path);
-    void render(const QSize &viewSize);
+    void render(const QSize &viewSize, int requestId, bool isDraft);
 
 signals:
-    void rendered(QImage);
+    void rendered(QImage, int requestId, bool isDraft);
 
 private:
     const float m_dpiRatio;
     mutable QMutex m_mutex;
+    QAtomicInt m_requestId;
     ResvgOptions m_opt;
     ResvgRenderer m_renderer;
 };
@@ -74,7 +79,7 @@ private:
     void drawSpinner(QPainter &p);
 
 private slots:
-    void onRendered(const QImage &img);
+    void onRendered(const QImage &img, int requestId, bool isDraft);
 
 private:
     const QImage m_checkboardImg;
@@ -88,6 +93,8 @@ private:
     bool m_isDrawImageBorder = false;
     bool m_isHasImage = false;
     QImage m_img;
+    QSize m_requestedSize;
+    int m_requestId = 0;
 
     QBasicTimer m_timer;
     int m_angle = 0;